@@ -0,0 +1,131 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <vector>
+#include <algorithm>
+
+// bump allocator for short-lived search buffers, usable by any std::pmr container. freeing a block
+// does nothing; memory comes back in bulk by rewinding to a mark or resetting. rewinding keeps the
+// chunks for reuse, and a reset merges them into one chunk as large as the most ever in use, so a
+// search that resets per iteration or ply stops allocating once its working set stops growing
+class Arena : public std::pmr::memory_resource {
+public:
+    struct Mark {
+        size_t chunk;
+        size_t used;
+    };
+
+    explicit Arena(size_t chunk_size = size_t{1} << 20) : chunk_size(chunk_size) {}
+
+    Arena(const Arena &) = delete;
+    Arena &operator=(const Arena &) = delete;
+
+    Mark mark() const {
+        return {current, used};
+    }
+
+    // releases everything allocated since mark was taken; containers using it must be gone by then
+    void rewind(const Mark &mark) {
+        current = mark.chunk;
+        used = mark.used;
+        before_current = 0;
+        for (size_t chunk = 0; chunk < current; ++chunk) {
+            before_current += chunks[chunk].size;
+        }
+    }
+
+    void reset() {
+        if (chunks.size() > 1) {
+            size_t size = std::max(chunk_size, most_in_use);
+            chunks.clear();
+            chunks.push_back(Chunk{std::make_unique_for_overwrite<std::byte[]>(size), size});
+        }
+        rewind({0, 0});
+    }
+
+    // bytes held in chunks, in use or not
+    size_t capacity() const {
+        size_t total = 0;
+        for (const auto &chunk: chunks) {
+            total += chunk.size;
+        }
+        return total;
+    }
+
+private:
+    struct Chunk {
+        std::unique_ptr<std::byte[]> memory;
+        size_t size;
+    };
+
+    void *do_allocate(size_t bytes, size_t alignment) override {
+        while (current < chunks.size()) {
+            auto &chunk = chunks[current];
+            auto address = reinterpret_cast<uintptr_t>(chunk.memory.get()) + used;
+            size_t padding = (alignment - address % alignment) % alignment;
+            if (used + padding + bytes <= chunk.size) {
+                used += padding + bytes;
+                most_in_use = std::max(most_in_use, before_current + used);
+                return chunk.memory.get() + used - bytes;
+            }
+            // a later chunk kept from before a rewind may have room, otherwise a new one goes here
+            if (current + 1 < chunks.size() && chunks[current + 1].size >= bytes + alignment) {
+                before_current += chunk.size;
+                ++current;
+                used = 0;
+                continue;
+            }
+            break;
+        }
+        size_t size = std::max(chunk_size, bytes + alignment);
+        if (chunks.empty()) {
+            chunks.push_back(Chunk{std::make_unique_for_overwrite<std::byte[]>(size), size});
+        } else {
+            before_current += chunks[current].size;
+            chunks.insert(chunks.begin() + current + 1,
+                          Chunk{std::make_unique_for_overwrite<std::byte[]>(size), size});
+            ++current;
+        }
+        used = 0;
+        return do_allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void *, size_t, size_t) override {}
+
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override {
+        return this == &other;
+    }
+
+    size_t chunk_size;
+    std::vector<Chunk> chunks;
+    size_t current = 0;
+    size_t used = 0;
+    // bytes of the chunks before the current one, and the most of all chunks ever in use
+    size_t before_current = 0;
+    size_t most_in_use = 0;
+};
+
+// rewinds the arena to where it was when the scope opened; declare it before the containers it serves
+class ArenaScope {
+public:
+    explicit ArenaScope(Arena &arena) : arena(arena), start(arena.mark()) {}
+
+    ArenaScope(const ArenaScope &) = delete;
+    ArenaScope &operator=(const ArenaScope &) = delete;
+
+    ~ArenaScope() {
+        arena.rewind(start);
+    }
+
+private:
+    Arena &arena;
+    Arena::Mark start;
+};
+
+inline Arena &thread_arena() {
+    thread_local Arena arena;
+    return arena;
+}
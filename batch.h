@@ -0,0 +1,134 @@
+#pragma once
+
+#include <istream>
+#include <vector>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <algorithm>
+#include <stdexcept>
+
+#include "simulation.h"
+#include "trace.h"
+#include "numa.h"
+
+struct BatchResult {
+    size_t seed;
+    int score;
+    std::vector<Move> moves;
+};
+
+// reads items in chunks and processes them on a pool of threads; results are handed to emit in input
+// order, chunks finished out of order wait in a reorder buffer of bounded size
+template<typename Item, typename Result, typename Read, typename Process, typename Emit>
+size_t process_in_order(Read read, Process process, Emit emit, size_t n_threads, size_t chunk_size = 1024) {
+    n_threads = std::max<size_t>(n_threads, 1);
+    size_t max_in_flight = 4 * n_threads;
+
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::deque<std::pair<size_t, std::vector<Item>>> work;
+    std::map<size_t, std::vector<Result>> finished;
+    bool input_done = false;
+    size_t n_chunks = 0;
+    size_t next_to_emit = 0;
+    size_t n_items = 0;
+
+    std::vector<std::thread> workers;
+    for (size_t index = 0; index < n_threads; ++index) {
+        workers.emplace_back([&, index] {
+            pin_worker(index, n_threads);
+            while (true) {
+                std::unique_lock lock(mutex);
+                changed.wait(lock, [&] { return !work.empty() || input_done; });
+                if (work.empty()) { return; }
+                auto [sequence, items] = std::move(work.front());
+                work.pop_front();
+                lock.unlock();
+
+                TraceSpan span("batch chunk");
+                std::vector<Result> results;
+                results.reserve(items.size());
+                for (const auto &item: items) {
+                    results.push_back(process(item));
+                }
+
+                lock.lock();
+                finished.emplace(sequence, std::move(results));
+                changed.notify_all();
+            }
+        });
+    }
+
+    auto emit_ready = [&](std::unique_lock<std::mutex> &lock) {
+        while (!finished.empty() && finished.begin()->first == next_to_emit) {
+            auto results = std::move(finished.begin()->second);
+            finished.erase(finished.begin());
+            lock.unlock();
+            for (const auto &result: results) {
+                emit(result);
+            }
+            lock.lock();
+            n_items += results.size();
+            ++next_to_emit;
+        }
+    };
+    auto next_ready = [&] { return !finished.empty() && finished.begin()->first == next_to_emit; };
+
+    while (true) {
+        std::vector<Item> items;
+        items.reserve(chunk_size);
+        bool more = read(items, chunk_size);
+
+        std::unique_lock lock(mutex);
+        if (!items.empty()) {
+            work.emplace_back(n_chunks++, std::move(items));
+            changed.notify_one();
+        }
+        if (!more) {
+            input_done = true;
+            changed.notify_all();
+            while (next_to_emit < n_chunks) {
+                changed.wait(lock, next_ready);
+                emit_ready(lock);
+            }
+            break;
+        }
+        while (n_chunks - next_to_emit >= max_in_flight) {
+            changed.wait(lock, next_ready);
+            emit_ready(lock);
+        }
+        emit_ready(lock);
+    }
+
+    for (auto &worker: workers) {
+        worker.join();
+    }
+    return n_items;
+}
+
+template<size_t size, typename Emit>
+size_t simulate_batch(std::istream &input, Policy policy, size_t n_threads, Emit emit) {
+    bool parse_error = false;
+    auto read = [&](std::vector<size_t> &seeds, size_t chunk_size) {
+        size_t seed;
+        while (seeds.size() < chunk_size && input >> seed) {
+            seeds.push_back(seed);
+        }
+        parse_error = !input && !input.eof();
+        return bool(input);
+    };
+    auto play = [policy](size_t seed) {
+        BatchResult result{seed};
+        result.score = play_game<size>(seed, policy, result.moves);
+        return result;
+    };
+
+    auto n_games = process_in_order<size_t, BatchResult>(read, play, emit, n_threads);
+    if (parse_error) {
+        throw std::runtime_error("unable to parse seed after " + std::to_string(n_games) + " games");
+    }
+    return n_games;
+}
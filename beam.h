@@ -0,0 +1,152 @@
+#pragma once
+
+#include <vector>
+#include <memory_resource>
+#include <thread>
+#include <barrier>
+#include <algorithm>
+
+#include "board.h"
+#include "bitboard.h"
+#include "evaluation.h"
+#include "simulation.h"
+#include "trace.h"
+#include "numa.h"
+#include "hugepage.h"
+#include "arena.h"
+
+template<size_t size>
+class BeamSearch {
+public:
+    BeamSearch(const BitBoard<size> &root, size_t width, Heuristic heuristic, size_t n_threads)
+            : root(root), width(width), heuristic(heuristic), n_threads(std::max<size_t>(n_threads, 1)),
+              workers(this->n_threads) {
+        max_depth = popcount(root.pegs);
+        for (auto &worker: workers) {
+            worker.moves.reserve(4 * size * size);
+        }
+        beam.reserve(this->n_threads * width);
+        next_beam.reserve(this->n_threads * width);
+        trail.resize(max_depth * width);
+    }
+
+    SearchResult search() {
+        beam.clear();
+        beam.push_back(Candidate{root, 0, {}, 0});
+        SearchResult result;
+
+        std::barrier sync(n_threads + 1);
+        bool finished = false;
+        std::vector<std::thread> threads;
+        for (size_t index = 0; index < n_threads; ++index) {
+            threads.emplace_back([&, index] {
+                pin_worker(index, n_threads);
+                while (true) {
+                    sync.arrive_and_wait();
+                    if (finished) { return; }
+                    TraceSpan span("beam expand");
+                    expand(index);
+                    sync.arrive_and_wait();
+                }
+            });
+        }
+
+        size_t depth = 0;
+        while (!beam.empty()) {
+            sync.arrive_and_wait();
+            sync.arrive_and_wait();
+
+            TraceSpan span("beam select");
+            next_beam.clear();
+            for (auto &worker: workers) {
+                next_beam.insert(next_beam.end(), worker.candidates.begin(), worker.candidates.end());
+            }
+            if (next_beam.empty()) { break; }
+            select_best(next_beam);
+
+            for (size_t index = 0; index < next_beam.size(); ++index) {
+                trail[depth * width + index] = {next_beam[index].parent, next_beam[index].move};
+                next_beam[index].parent = index;
+            }
+            std::swap(beam, next_beam);
+            ++depth;
+            result.n_playouts += beam.size();
+        }
+
+        finished = true;
+        sync.arrive_and_wait();
+        for (auto &thread: threads) {
+            thread.join();
+        }
+
+        result.score = popcount(beam.front().board.pegs);
+        result.moves.resize(depth);
+        size_t index = 0;
+        for (size_t ply = depth; ply-- > 0;) {
+            const auto &[parent, move] = trail[ply * width + index];
+            result.moves[ply] = move;
+            index = parent;
+        }
+        return result;
+    }
+
+private:
+    struct Candidate {
+        BitBoard<size> board;
+        size_t parent;
+        Move move;
+        int score;
+    };
+
+    // the children a worker generates for one ply live in its own arena, which is reset at the next ply
+    // once they have been merged into the beam
+    struct Worker {
+        Arena arena;
+        std::pmr::vector<Candidate> candidates{&arena};
+        size_t most_candidates = 0;
+        std::vector<Move> moves;
+    };
+
+    void expand(size_t index) {
+        auto &worker = workers[index];
+        worker.candidates = std::pmr::vector<Candidate>(&worker.arena);
+        worker.arena.reset();
+        worker.candidates.reserve(worker.most_candidates);
+        for (size_t parent = index; parent < beam.size(); parent += n_threads) {
+            get_moves(beam[parent].board, worker.moves);
+            for (const auto &move: worker.moves) {
+                auto board = beam[parent].board;
+                do_move(board, move);
+                int score = evaluate(board, heuristic);
+                worker.candidates.push_back(Candidate{board, parent, move, score});
+            }
+        }
+        worker.most_candidates = std::max(worker.most_candidates, worker.candidates.size());
+        select_best(worker.candidates);
+    }
+
+    template<typename Candidates>
+    void select_best(Candidates &candidates) const {
+        std::sort(candidates.begin(), candidates.end(), [](const auto &a, const auto &b) {
+            return a.board.pegs < b.board.pegs;
+        });
+        auto last = std::unique(candidates.begin(), candidates.end(), [](const auto &a, const auto &b) {
+            return a.board == b.board;
+        });
+        candidates.erase(last, candidates.end());
+        if (candidates.size() <= width) { return; }
+        std::nth_element(candidates.begin(), candidates.begin() + width, candidates.end(),
+                         [](const auto &a, const auto &b) { return a.score < b.score; });
+        candidates.resize(width);
+    }
+
+    BitBoard<size> root;
+    size_t width;
+    Heuristic heuristic;
+    size_t n_threads;
+    size_t max_depth;
+    std::vector<Worker> workers;
+    std::vector<Candidate> beam;
+    std::vector<Candidate> next_beam;
+    HugeVector<std::tuple<size_t, Move>> trail;
+};
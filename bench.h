@@ -0,0 +1,144 @@
+#pragma once
+
+#include <chrono>
+#include <vector>
+#include <algorithm>
+
+#include "simulation.h"
+#include "perf.h"
+
+struct BenchResult {
+    size_t n_games = 0;
+    size_t n_moves = 0;
+    double seconds = 0;
+    int best_score = INT_MAX;
+};
+
+// plays the fixed seeds 1..n_games, so runs are comparable across builds
+template<size_t size>
+BenchResult run_benchmark(Policy policy, size_t n_games) {
+    BenchResult result;
+    std::vector<Move> move_history;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t seed = 1; seed <= n_games; ++seed) {
+        int score = play_game<size>(seed, policy, move_history);
+        result.n_moves += move_history.size();
+        result.best_score = std::min(result.best_score, score);
+    }
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    result.n_games = n_games;
+    return result;
+}
+
+struct BenchProfile {
+    size_t n_games = 0;
+    size_t n_moves = 0;
+    PerfCounts playout;
+    PerfCounts rng;
+    PerfCounts generation;
+    PerfCounts application;
+};
+
+// hardware counts of the seeds 1..n_games for whole playouts and, with phases, for the three phases a
+// scan playout is made of: drawing the two offsets, finding the move from them and applying it. reading
+// counters around every move would cost more than the move, so each chunk of games is played once
+// counted, then replayed uncounted to record its positions, on which every phase is counted alone
+template<size_t size>
+BenchProfile profile_benchmark(Policy policy, size_t n_games, bool phases, size_t chunk_size = 1000) {
+    BenchProfile profile;
+    PerfCounters playout, rng, generation, application;
+    std::vector<Move> moves;
+    std::vector<Move> played;
+    std::vector<size_t> game_lengths;
+    std::vector<BitBoard<size>> positions;
+    std::vector<Coordinate> offsets;
+    uint64_t sink = 0;
+
+    for (size_t first = 1; first <= n_games; first += chunk_size) {
+        size_t last = std::min(n_games, first + chunk_size - 1);
+        playout.start();
+        for (size_t seed = first; seed <= last; ++seed) {
+            sink += play_game<size>(seed, policy, moves);
+            profile.n_moves += moves.size();
+        }
+        playout.stop();
+        profile.n_games += last - first + 1;
+        if (!phases) { continue; }
+
+        played.clear();
+        game_lengths.clear();
+        positions.clear();
+        offsets.clear();
+        for (size_t seed = first; seed <= last; ++seed) {
+            play_game<size>(seed, policy, moves);
+            auto board = start_board<size>;
+            for (const auto &move: moves) {
+                positions.push_back(board);
+                offsets.push_back({random_below(size), random_below(size)});
+                do_move(board, move);
+            }
+            played.insert(played.end(), moves.begin(), moves.end());
+            game_lengths.push_back(moves.size());
+        }
+
+        rng.start();
+        for (size_t index = 0; index < positions.size(); ++index) {
+            sink += random_below(size);
+            sink += random_below(size);
+        }
+        rng.stop();
+
+        generation.start();
+        for (size_t index = 0; index < positions.size(); ++index) {
+            auto move = get_move(positions[index], offsets[index]);
+            sink += move ? std::get<0>(move->to) : 0;
+        }
+        generation.stop();
+
+        application.start();
+        auto move = played.begin();
+        for (auto length: game_lengths) {
+            auto board = start_board<size>;
+            for (size_t jump = 0; jump < length; ++jump) {
+                do_move(board, *move++);
+            }
+            sink += uint64_t(board.pegs);
+        }
+        application.stop();
+    }
+    asm volatile("" : : "r"(sink));
+
+    profile.playout = playout.read();
+    profile.rng = rng.read();
+    profile.generation = generation.read();
+    profile.application = application.read();
+    return profile;
+}
+
+// bounded draws per second, one at a time as the playouts use them
+template<typename Generator>
+double benchmark_draws(Generator &generator, size_t n_draws) {
+    uint64_t sink = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t drawn = 0; drawn < n_draws; ++drawn) {
+        sink += generator.below(9);
+    }
+    auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    asm volatile("" : : "r"(sink));
+    return n_draws / seconds;
+}
+
+// raw 64 bit values per second through the bulk fill
+template<typename Generator>
+double benchmark_fill(Generator &generator, size_t n_draws) {
+    std::vector<uint64_t> values(4096);
+    uint64_t sink = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t drawn = 0; drawn < n_draws; drawn += values.size()) {
+        generator.fill(values);
+        sink += values[drawn % values.size()];
+    }
+    auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    asm volatile("" : : "r"(sink));
+    return n_draws / seconds;
+}
@@ -0,0 +1,308 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <vector>
+#include <optional>
+#include <span>
+#include <cassert>
+
+#include "board.h"
+
+using Bits = unsigned __int128;
+
+// cells are numbered row * (size + 1) + column; the padding column is never usable,
+// so horizontal shifts cannot wrap a jump from one row into the next
+template<size_t size>
+constexpr size_t stride = size + 1;
+
+template<size_t size>
+constexpr size_t cell_index(size_t row, size_t column) {
+    return row * stride<size> + column;
+}
+
+template<size_t size>
+constexpr Bits cell_bit(size_t row, size_t column) {
+    return Bits{1} << cell_index<size>(row, column);
+}
+
+template<size_t size>
+constexpr bool is_usable(size_t row, size_t column) {
+    for (auto edge: {size_t{0}, size - 1}) {
+        if (row == edge && (column < 2 || column > size - 3)) { return false; }
+    }
+    for (auto edge: {size_t{1}, size - 2}) {
+        if (row == edge && (column == 0 || column == size - 1)) { return false; }
+    }
+    return true;
+}
+
+template<size_t size, typename Predicate>
+constexpr Bits make_mask(Predicate predicate) {
+    Bits mask = 0;
+    for (size_t row = 0; row < size; ++row) {
+        for (size_t column = 0; column < size; ++column) {
+            if (is_usable<size>(row, column) && predicate(row, column)) {
+                mask |= cell_bit<size>(row, column);
+            }
+        }
+    }
+    return mask;
+}
+
+template<size_t size>
+constexpr Bits usable_mask = make_mask<size>([](size_t, size_t) { return true; });
+
+constexpr int popcount(Bits bits) {
+    return std::popcount(uint64_t(bits)) + std::popcount(uint64_t(bits >> 64));
+}
+
+constexpr int lowest_bit(Bits bits) {
+    auto low = uint64_t(bits);
+    return low ? std::countr_zero(low) : 64 + std::countr_zero(uint64_t(bits >> 64));
+}
+
+constexpr uint64_t hash_bits(Bits bits) {
+    auto hash = uint64_t(bits) ^ (uint64_t(bits >> 64) * 0x9e3779b97f4a7c15);
+    hash = (hash ^ (hash >> 30)) * 0xbf58476d1ce4e5b9;
+    hash = (hash ^ (hash >> 27)) * 0x94d049bb133111eb;
+    return hash ^ (hash >> 31);
+}
+
+struct BitsHash {
+    size_t operator()(Bits bits) const {
+        return hash_bits(bits);
+    }
+};
+
+template<size_t size>
+struct BitBoard {
+    Bits pegs = 0;
+
+    constexpr Bits empty() const {
+        return usable_mask<size> & ~pegs;
+    }
+
+    friend constexpr bool operator==(const BitBoard &, const BitBoard &) = default;
+};
+
+template<size_t size>
+constexpr BitBoard<size> to_bitboard(const Board<size> &board) {
+    BitBoard<size> result;
+    for (size_t row = 0; row < size; ++row) {
+        for (size_t column = 0; column < size; ++column) {
+            if (board[row][column] == FieldState::OCCUPIED) {
+                result.pegs |= cell_bit<size>(row, column);
+            }
+        }
+    }
+    return result;
+}
+
+template<size_t size>
+constexpr Board<size> to_board(const BitBoard<size> &bitboard) {
+    Board<size> board = {};
+    for (size_t row = 0; row < size; ++row) {
+        for (size_t column = 0; column < size; ++column) {
+            if (!is_usable<size>(row, column)) {
+                board[row][column] = FieldState::UNUSABLE;
+            } else if (bitboard.pegs & cell_bit<size>(row, column)) {
+                board[row][column] = FieldState::OCCUPIED;
+            } else {
+                board[row][column] = FieldState::EMPTY;
+            }
+        }
+    }
+    return board;
+}
+
+template<size_t size>
+constexpr Bits centre_mask = cell_bit<size>(size / 2, size / 2);
+
+// usable orthogonal neighbours of every cell, by cell index
+template<size_t size>
+constexpr auto neighbour_masks = [] {
+    std::array<Bits, size * stride<size>> masks{};
+    for (size_t row = 0; row < size; ++row) {
+        for (size_t column = 0; column < size; ++column) {
+            Bits neighbours = 0;
+            if (row > 0) { neighbours |= cell_bit<size>(row - 1, column); }
+            if (row + 1 < size) { neighbours |= cell_bit<size>(row + 1, column); }
+            if (column > 0) { neighbours |= cell_bit<size>(row, column - 1); }
+            if (column + 1 < size) { neighbours |= cell_bit<size>(row, column + 1); }
+            masks[cell_index<size>(row, column)] = neighbours & usable_mask<size>;
+        }
+    }
+    return masks;
+}();
+
+// the board every game starts from, built and checked at compile time so a game begins with a copy
+template<size_t size>
+constexpr BitBoard<size> start_board = [] {
+    static_assert(size * stride<size> <= 128, "cells must fit in Bits");
+    constexpr auto board = to_bitboard(make_board<size>());
+    static_assert(board.empty() == centre_mask<size>, "the centre must be the only hole");
+    static_assert(popcount(usable_mask<size>) == int(size * size - 12), "only the corners may be cut");
+    static_assert([] {
+        for (size_t row = 0; row < size; ++row) {
+            for (size_t column = 0; column < size; ++column) {
+                bool usable = is_usable<size>(row, column);
+                if (usable != is_usable<size>(size - 1 - row, column) ||
+                    usable != is_usable<size>(row, size - 1 - column) || usable != is_usable<size>(column, row)) {
+                    return false;
+                }
+                if (usable && neighbour_masks<size>[cell_index<size>(row, column)] == 0) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }(), "the board must have the symmetries of a square and no isolated cells");
+    return board;
+}();
+
+// right, down, up, left; same order as get_move
+template<size_t size>
+constexpr std::array<int, 4> jump_directions = {1, int(stride<size>), -int(stride<size>), -1};
+
+constexpr Bits shift(Bits bits, int amount) {
+    return amount >= 0 ? bits >> amount : bits << -amount;
+}
+
+// pegs that can jump in a given direction
+template<size_t size>
+constexpr Bits jump_sources(const BitBoard<size> &board, int direction) {
+    return board.pegs & shift(board.pegs, direction) & shift(board.empty(), 2 * direction);
+}
+
+template<size_t size>
+constexpr Move to_move(int from, int direction) {
+    int to = from + 2 * direction;
+    return Move{{from / stride<size>, from % stride<size>},
+                {to / stride<size>,   to % stride<size>}};
+}
+
+template<size_t size>
+Bits get_jump_sources(const BitBoard<size> &board, std::array<Bits, 4> &sources) {
+    Bits any = 0;
+    for (size_t index = 0; index < 4; ++index) {
+        sources[index] = jump_sources(board, jump_directions<size>[index]);
+        any |= sources[index];
+    }
+    return any;
+}
+
+// same cyclic scan as get_move on Board, so both pick the same move for the same offset
+template<size_t size>
+std::optional<Move> get_move(const BitBoard<size> &board, Coordinate offset) {
+    std::array<Bits, 4> sources;
+    Bits any = get_jump_sources(board, sources);
+    if (!any) { return {}; }
+
+    auto [row_offset, column_offset] = offset;
+    size_t first_column = column_offset % size;
+    for (size_t row = 0; row < size; ++row) {
+        size_t offsetted_row = (row + row_offset) % size;
+        auto row_bits = uint64_t(any >> cell_index<size>(offsetted_row, 0)) & ((uint64_t{1} << size) - 1);
+        if (!row_bits) { continue; }
+        auto wrapped_bits = row_bits >> first_column << first_column;
+        int from = int(cell_index<size>(offsetted_row, std::countr_zero(wrapped_bits ? wrapped_bits : row_bits)));
+        for (size_t index = 0; index < 4; ++index) {
+            if (sources[index] & (Bits{1} << from)) {
+                return to_move<size>(from, jump_directions<size>[index]);
+            }
+        }
+    }
+    return {};
+}
+
+template<size_t size, typename Moves>
+void get_moves(const BitBoard<size> &board, Moves &moves) {
+    std::array<Bits, 4> sources;
+    Bits any = get_jump_sources(board, sources);
+
+    moves.clear();
+    for (; any; any &= any - 1) {
+        int from = lowest_bit(any);
+        for (size_t index = 0; index < 4; ++index) {
+            if (sources[index] & (Bits{1} << from)) {
+                moves.push_back(to_move<size>(from, jump_directions<size>[index]));
+            }
+        }
+    }
+}
+
+template<size_t size>
+constexpr bool is_legal(const BitBoard<size> &board, const Move &move) {
+    auto [from_row, from_column] = move.from;
+    auto [to_row, to_column] = move.to;
+    if (from_row >= size || from_column >= size || to_row >= size || to_column >= size) { return false; }
+    bool horizontal = from_row == to_row && (from_column + 2 == to_column || to_column + 2 == from_column);
+    bool vertical = from_column == to_column && (from_row + 2 == to_row || to_row + 2 == from_row);
+    if (!horizontal && !vertical) { return false; }
+    auto over = cell_bit<size>((from_row + to_row) / 2, (from_column + to_column) / 2);
+    return (board.pegs & cell_bit<size>(from_row, from_column)) && (board.pegs & over) &&
+           (board.empty() & cell_bit<size>(to_row, to_column));
+}
+
+template<size_t size>
+constexpr void do_move(BitBoard<size> &board, const Move &move) {
+    auto [from_row, from_column] = move.from;
+    auto [to_row, to_column] = move.to;
+    board.pegs ^= cell_bit<size>(from_row, from_column) | cell_bit<size>(to_row, to_column) |
+                  cell_bit<size>((from_row + to_row) / 2, (from_column + to_column) / 2);
+}
+
+// a jump flips the same three cells back, so undoing is the jump itself
+template<size_t size>
+constexpr void undo_move(BitBoard<size> &board, const Move &move) {
+    do_move(board, move);
+}
+
+// jumps played in place on a board and taken back in reverse order; deep enough for any game, as every
+// jump removes a peg
+template<size_t size>
+class MoveStack {
+public:
+    static constexpr size_t capacity = popcount(usable_mask<size>) - 1;
+
+    explicit MoveStack(BitBoard<size> &board) : position(board) {}
+
+    void push(const Move &move) {
+        assert(n_moves < capacity);
+        do_move(position, move);
+        played[n_moves++] = move;
+    }
+
+    Move pop() {
+        assert(n_moves > 0);
+        auto move = played[--n_moves];
+        undo_move(position, move);
+        return move;
+    }
+
+    // takes back every jump, restoring the board the stack was made for
+    void clear() {
+        while (n_moves > 0) {
+            pop();
+        }
+    }
+
+    const BitBoard<size> &board() const {
+        return position;
+    }
+
+    size_t depth() const {
+        return n_moves;
+    }
+
+    std::span<const Move> moves() const {
+        return {played.data(), n_moves};
+    }
+
+private:
+    BitBoard<size> &position;
+    std::array<Move, capacity> played;
+    size_t n_moves = 0;
+};
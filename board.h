@@ -0,0 +1,176 @@
+#pragma once
+
+#include <iostream>
+#include <array>
+#include <optional>
+#include <tuple>
+#include <cassert>
+#include <vector>
+#include <numeric>
+
+enum class FieldState {
+    UNUSABLE,
+    EMPTY,
+    OCCUPIED,
+};
+
+template<size_t size>
+using Board = std::array<std::array<FieldState, size>, size>;
+
+template<size_t size>
+constexpr Board<size> make_board() {
+    static_assert(size % 2 == 1, "Board size must be odd.");
+    static_assert(size >= 5, "Board size must leave room for the cut corners.");
+
+    Board<size> board = {};
+    for (auto &row: board) {
+        for (auto &cell: row) {
+            cell = FieldState::OCCUPIED;
+        }
+    }
+
+    for (auto index: std::array<size_t, 2>{{0, size - 1}}) {
+        board[index][0] = FieldState::UNUSABLE;
+        board[index][1] = FieldState::UNUSABLE;
+        board[index][size - 2] = FieldState::UNUSABLE;
+        board[index][size - 1] = FieldState::UNUSABLE;
+    }
+
+    for (auto index: std::array<size_t, 2>{1, size - 2}) {
+        board[index][0] = FieldState::UNUSABLE;
+        board[index][size - 1] = FieldState::UNUSABLE;
+    }
+
+    board[size / 2][size / 2] = FieldState::EMPTY;
+    return board;
+}
+
+template<size_t size>
+std::ostream &operator<<(std::ostream &os, const Board<size> &board) {
+
+    for (const auto &row: board) {
+        for (const auto &cell: row) {
+            switch (cell) {
+                case FieldState::UNUSABLE:
+                    os << ' ';
+                    break;
+                case FieldState::EMPTY:
+                    os << '.';
+                    break;
+                case FieldState::OCCUPIED:
+                    os << '@';
+                    break;
+                default:
+                    throw std::runtime_error("unknown cell type");
+            }
+        }
+        os << '\n';
+    }
+
+    return os;
+}
+
+using Coordinate = std::tuple<size_t, size_t>;
+
+struct Move {
+    Coordinate from;
+    Coordinate to;
+};
+
+inline std::ostream &operator<<(std::ostream &os, const Move &move) {
+    auto [from_row, from_column] = move.from;
+    auto [to_row, to_column] = move.to;
+    os << "(" << from_row << ", " << from_column << ") ~> (" << to_row << ", " << to_column << ")";
+    return os;
+}
+
+template<size_t size>
+std::optional<FieldState> get_from_board(const Board<size> &board, int row, int column) {
+    if (row < 0 || column < 0 || row >= size || column >= size) {
+        return {};
+    }
+
+    return board[row][column];
+}
+
+template<size_t size>
+std::optional<Move> get_move(const Board<size> &board, Coordinate offset) {
+    auto directions = std::array<std::tuple<int, int>, 4>{std::tuple{0, 1}, {1, 0}, {-1, 0}, {0, -1}};
+
+    for (int row = 0; row < size; ++row) {
+        for (int column = 0; column < size; ++column) {
+            auto [row_offset, column_offset] = offset;
+
+            int offsetted_row = (row + row_offset) % size;
+            int offsetted_column = (column + column_offset) % size;
+
+            auto cell = get_from_board(board, offsetted_row, offsetted_column);
+            assert(cell);
+            if (cell.value() == FieldState::OCCUPIED) {
+                for (const auto &[row_direction, column_direction]: directions) {
+                    auto next_to = get_from_board(board, offsetted_row + row_direction,
+                                                  offsetted_column + column_direction);
+                    if (!next_to || (*next_to != FieldState::OCCUPIED)) { continue; }
+                    auto target_row = offsetted_row + 2 * row_direction;
+                    auto target_column = offsetted_column + 2 * column_direction;
+                    auto over_one = get_from_board(board, target_row, target_column);
+                    if (!over_one || (*over_one != FieldState::EMPTY)) { continue; }
+                    return Move{{offsetted_row, offsetted_column},
+                                {target_row,    target_column}};
+                }
+            }
+        }
+    }
+    return {};
+}
+
+
+template<size_t size>
+void get_moves(const Board<size> &board, std::vector<Move> &moves) {
+    auto directions = std::array<std::tuple<int, int>, 4>{std::tuple{0, 1}, {1, 0}, {-1, 0}, {0, -1}};
+
+    moves.clear();
+    for (int row = 0; row < size; ++row) {
+        for (int column = 0; column < size; ++column) {
+            if (board[row][column] != FieldState::OCCUPIED) { continue; }
+            for (const auto &[row_direction, column_direction]: directions) {
+                auto next_to = get_from_board(board, row + row_direction, column + column_direction);
+                if (!next_to || (*next_to != FieldState::OCCUPIED)) { continue; }
+                auto target_row = row + 2 * row_direction;
+                auto target_column = column + 2 * column_direction;
+                auto over_one = get_from_board(board, target_row, target_column);
+                if (!over_one || (*over_one != FieldState::EMPTY)) { continue; }
+                moves.push_back(Move{{row,        column},
+                                     {target_row, target_column}});
+            }
+        }
+    }
+}
+
+template<size_t size>
+void do_move(Board<size> &board, const Move &move) {
+    auto [from_row, from_column] = move.from;
+    auto [to_row, to_column] = move.to;
+
+    auto &from = board[from_row][from_column];
+    assert(from == FieldState::OCCUPIED);
+    from = FieldState::EMPTY;
+
+    auto &to = board[to_row][to_column];
+    assert(from == FieldState::EMPTY);
+    to = FieldState::OCCUPIED;
+    auto &over = board[std::midpoint(from_row, to_row)][std::midpoint(from_column, to_column)];
+    assert(over == FieldState::OCCUPIED);
+    over = FieldState::EMPTY;
+}
+
+template<size_t size>
+int get_score(const Board<size> &board) {
+    int result = 0;
+    for (const auto &row: board) {
+        for (auto cell: row) {
+            result += cell == FieldState::OCCUPIED;
+        }
+    }
+    return result;
+}
@@ -0,0 +1,398 @@
+#pragma once
+
+#include <cstdint>
+#include <cerrno>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <optional>
+#include <unordered_map>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "bitboard.h"
+#include "trace.h"
+#include "hugepage.h"
+
+// a solved-position cache is a table file of positions proven to reach a target pattern or not, plus a
+// write-ahead log next to it ("<path>.log") that solvers append their new proofs to. the table is an
+// open addressing hash table of fixed capacity mapped read-only, so any number of processes share it;
+// compaction merges the log into a new table that replaces the old one by rename
+constexpr uint8_t cache_version = 1;
+
+struct CacheHeader {
+    char magic[4];
+    uint8_t version;
+    uint8_t board_size;
+    uint8_t reserved[2];
+    uint64_t layout;
+    uint64_t target[2];
+    // slots of the table, a power of two, and the number in use; both zero in the log
+    uint64_t capacity;
+    uint64_t n_entries;
+    uint64_t unused[2];
+};
+
+static_assert(sizeof(CacheHeader) == 64);
+
+// slots and log records hold the pegs as two little endian words, the highest bit set for positions
+// that reach the target; zero marks an empty slot, which no position is
+constexpr size_t cache_slot_size = 16;
+constexpr Bits cache_winning_flag = Bits{1} << 127;
+
+inline void store_slot(unsigned char *slot, Bits value) {
+    uint64_t words[2] = {uint64_t(value), uint64_t(value >> 64)};
+    std::memcpy(slot, words, sizeof(words));
+}
+
+inline Bits load_slot(const unsigned char *slot) {
+    uint64_t words[2];
+    std::memcpy(words, slot, sizeof(words));
+    return Bits(words[1]) << 64 | words[0];
+}
+
+inline std::string cache_log_path(const std::string &path) {
+    return path + ".log";
+}
+
+inline bool same_cache_key(const CacheHeader &a, const CacheHeader &b) {
+    return a.board_size == b.board_size && a.layout == b.layout && a.target[0] == b.target[0] &&
+           a.target[1] == b.target[1];
+}
+
+// throws unless header starts a cache table (magic "SIRC") or log ("SIRL") of the current version
+inline void check_cache_header(const std::string &path, const CacheHeader &header, const char *magic) {
+    if (std::memcmp(header.magic, magic, 4) != 0 || header.version != cache_version) {
+        throw std::runtime_error(path + " is not a solved-position cache of version " +
+                                 std::to_string(cache_version));
+    }
+}
+
+// open addressing probe for pegs; returns the slot holding them or the empty slot ending the probe
+inline const unsigned char *probe_slot(const unsigned char *slots, uint64_t capacity, Bits pegs) {
+    for (uint64_t index = hash_bits(pegs) & (capacity - 1);; index = (index + 1) & (capacity - 1)) {
+        auto slot = slots + index * cache_slot_size;
+        auto value = load_slot(slot);
+        if (value == 0 || (value & ~cache_winning_flag) == pegs) {
+            return slot;
+        }
+    }
+}
+
+// a locked file descriptor, unlocked and closed when it goes out of scope
+class LockedFile {
+public:
+    LockedFile(const std::string &path, int flags, int operation) {
+        fd = ::open(path.c_str(), flags, 0644);
+        if (fd < 0) {
+            throw std::runtime_error("unable to open " + path + ": " + std::strerror(errno));
+        }
+        while (::flock(fd, operation) < 0) {
+            if (errno == EINTR) { continue; }
+            auto error = errno;
+            ::close(fd);
+            throw std::runtime_error(error == EWOULDBLOCK ? path + " is in use"
+                                                          : "unable to lock " + path + ": " + std::strerror(error));
+        }
+    }
+
+    LockedFile(const LockedFile &) = delete;
+    LockedFile &operator=(const LockedFile &) = delete;
+
+    ~LockedFile() {
+        ::close(fd);
+    }
+
+    int get() const {
+        return fd;
+    }
+
+private:
+    int fd;
+};
+
+inline void write_all(int fd, const void *data, size_t length, const std::string &path) {
+    auto bytes = static_cast<const char *>(data);
+    while (length > 0) {
+        auto written = ::write(fd, bytes, length);
+        if (written < 0) {
+            if (errno == EINTR) { continue; }
+            throw std::runtime_error("unable to write " + path + ": " + std::strerror(errno));
+        }
+        bytes += written;
+        length -= written;
+    }
+}
+
+// reads the whole records of a log opened and locked by the caller, dropping a record torn by a crash
+// when the lock is exclusive
+inline std::vector<Bits> read_cache_log(int fd, const std::string &path, CacheHeader &header, bool repair) {
+    struct stat status{};
+    if (::fstat(fd, &status) < 0) {
+        throw std::runtime_error("unable to read " + path + ": " + std::strerror(errno));
+    }
+    size_t length = status.st_size;
+    if (length < sizeof(CacheHeader)) {
+        throw std::runtime_error(path + " is not a solved-position cache log");
+    }
+    std::vector<unsigned char> bytes(length);
+    for (size_t offset = 0; offset < length;) {
+        auto n_read = ::pread(fd, bytes.data() + offset, length - offset, off_t(offset));
+        if (n_read <= 0) {
+            if (n_read < 0 && errno == EINTR) { continue; }
+            throw std::runtime_error("unable to read " + path);
+        }
+        offset += n_read;
+    }
+    std::memcpy(&header, bytes.data(), sizeof(header));
+    check_cache_header(path, header, "SIRL");
+
+    size_t n_records = (length - sizeof(CacheHeader)) / cache_slot_size;
+    size_t whole = sizeof(CacheHeader) + n_records * cache_slot_size;
+    if (whole != length && repair && ::ftruncate(fd, off_t(whole)) < 0) {
+        throw std::runtime_error("unable to repair " + path + ": " + std::strerror(errno));
+    }
+    std::vector<Bits> records(n_records);
+    for (size_t index = 0; index < n_records; ++index) {
+        records[index] = load_slot(bytes.data() + sizeof(CacheHeader) + index * cache_slot_size);
+    }
+    return records;
+}
+
+// the positions proven for one board and target: the mapped table and the log as it was when opened.
+// new proofs are buffered and appended to the log under a shared lock, so concurrent solvers can share
+// a cache; compaction takes the lock exclusively
+template<size_t size>
+class SolvedCache {
+public:
+    static_assert(size * stride<size> < 127, "the winning flag must not overlap a cell");
+
+    SolvedCache(const std::string &path, Bits target, size_t buffer_size = 1 << 16) : log_path(cache_log_path(path)) {
+        uint64_t target_words[2] = {uint64_t(target), uint64_t(target >> 64)};
+        key = CacheHeader{{'S', 'I', 'R', 'L'}, cache_version, uint8_t(size), {}, hash_bits(usable_mask<size>),
+                          {target_words[0], target_words[1]}, 0, 0, {}};
+        map_table(path);
+
+        // the log is created, checked and repaired under an exclusive lock so no append is in flight
+        LockedFile log(log_path, O_RDWR | O_CREAT, LOCK_EX);
+        struct stat status{};
+        if (::fstat(log.get(), &status) < 0) {
+            throw std::runtime_error("unable to read " + log_path + ": " + std::strerror(errno));
+        }
+        if (status.st_size == 0) {
+            write_all(log.get(), &key, sizeof(key), log_path);
+        }
+        CacheHeader header;
+        for (auto record: read_cache_log(log.get(), log_path, header, true)) {
+            logged.emplace(record & ~cache_winning_flag, (record & cache_winning_flag) != 0);
+        }
+        if (!same_cache_key(header, key)) {
+            throw std::runtime_error(log_path + " was written for a different board layout or target");
+        }
+        n_logged = logged.size();
+        buffer.reserve(buffer_size);
+    }
+
+    SolvedCache(const SolvedCache &) = delete;
+    SolvedCache &operator=(const SolvedCache &) = delete;
+
+    ~SolvedCache() {
+        try {
+            flush();
+        } catch (const std::exception &) {
+            // the proofs are lost, the cache stays consistent
+        }
+        if (table) {
+            ::munmap(const_cast<unsigned char *>(table), table_length);
+        }
+    }
+
+    // whether pegs reach the target, if an earlier run has proven it
+    std::optional<bool> lookup(Bits pegs) const {
+        if (logged.empty() && !table) { return {}; }
+        if (auto found = logged.find(pegs); found != logged.end()) {
+            return found->second;
+        }
+        if (table) {
+            auto value = load_slot(probe_slot(table + sizeof(CacheHeader), table_capacity, pegs));
+            if (value) {
+                return (value & cache_winning_flag) != 0;
+            }
+        }
+        return {};
+    }
+
+    // appends a proof unless the cache already knew it; the solver records every position at most once,
+    // so proofs of this run are not looked up again and lookups stay as cheap as the cache was at start
+    void record(Bits pegs, bool winning) {
+        if (lookup(pegs)) { return; }
+        if (buffer.size() + cache_slot_size > buffer.capacity()) {
+            flush();
+        }
+        buffer.resize(buffer.size() + cache_slot_size);
+        store_slot(buffer.data() + buffer.size() - cache_slot_size, pegs | (winning ? cache_winning_flag : 0));
+        ++n_recorded;
+    }
+
+    // appends the buffered records in one write, so records of concurrent solvers never interleave
+    void flush() {
+        if (buffer.empty()) { return; }
+        TraceSpan span("cache flush");
+        LockedFile log(log_path, O_WRONLY | O_APPEND, LOCK_SH);
+        write_all(log.get(), buffer.data(), buffer.size(), log_path);
+        buffer.clear();
+    }
+
+    size_t table_entries() const {
+        return table_size;
+    }
+
+    // positions in the log when it was opened
+    size_t logged_entries() const {
+        return n_logged;
+    }
+
+    size_t recorded_entries() const {
+        return n_recorded;
+    }
+
+private:
+    void map_table(const std::string &path) {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            if (errno == ENOENT) { return; }
+            throw std::runtime_error("unable to open " + path + ": " + std::strerror(errno));
+        }
+        struct stat status{};
+        CacheHeader header{};
+        if (::fstat(fd, &status) < 0 || size_t(status.st_size) < sizeof(header) ||
+            ::pread(fd, &header, sizeof(header), 0) != sizeof(header)) {
+            ::close(fd);
+            throw std::runtime_error(path + " is not a solved-position cache");
+        }
+        check_cache_header(path, header, "SIRC");
+        if (!same_cache_key(header, key)) {
+            ::close(fd);
+            throw std::runtime_error(path + " was built for a different board layout or target");
+        }
+        if (header.capacity == 0 || (header.capacity & (header.capacity - 1)) != 0 ||
+            size_t(status.st_size) != sizeof(header) + header.capacity * cache_slot_size) {
+            ::close(fd);
+            throw std::runtime_error(path + " is truncated");
+        }
+        table_length = status.st_size;
+        auto mapping = ::mmap(nullptr, table_length, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (mapping == MAP_FAILED) {
+            throw std::runtime_error("unable to map " + path + ": " + std::strerror(errno));
+        }
+        ::madvise(mapping, table_length, MADV_RANDOM);
+        table = static_cast<const unsigned char *>(mapping);
+        table_capacity = header.capacity;
+        table_size = header.n_entries;
+    }
+
+    std::string log_path;
+    CacheHeader key;
+    const unsigned char *table = nullptr;
+    size_t table_length = 0;
+    uint64_t table_capacity = 0;
+    size_t table_size = 0;
+    std::unordered_map<Bits, bool, BitsHash> logged;
+    std::vector<unsigned char> buffer;
+    size_t n_logged = 0;
+    size_t n_recorded = 0;
+};
+
+struct CompactionResult {
+    size_t n_entries;
+    size_t n_log_records;
+    uint64_t capacity;
+};
+
+// merges the log into a new table at most half full, written beside the old one and renamed over it,
+// then empties the log. the log stays locked exclusively throughout, so appends wait for it and
+// solvers that mapped the old table keep reading it until they exit
+inline CompactionResult compact_solved_cache(const std::string &path) {
+    auto log_path = cache_log_path(path);
+    LockedFile log(log_path, O_RDWR, LOCK_EX | LOCK_NB);
+    CacheHeader header;
+    auto records = read_cache_log(log.get(), log_path, header, true);
+
+    std::vector<Bits> entries;
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd >= 0) {
+        struct stat status{};
+        CacheHeader table_header{};
+        bool valid = ::fstat(fd, &status) == 0 && size_t(status.st_size) >= sizeof(table_header) &&
+                     ::pread(fd, &table_header, sizeof(table_header), 0) == sizeof(table_header);
+        std::vector<unsigned char> slots;
+        if (valid) {
+            check_cache_header(path, table_header, "SIRC");
+            valid = same_cache_key(table_header, header) &&
+                    size_t(status.st_size) == sizeof(table_header) + table_header.capacity * cache_slot_size;
+            slots.resize(status.st_size - sizeof(table_header));
+            valid = valid && ::pread(fd, slots.data(), slots.size(), sizeof(table_header)) == ssize_t(slots.size());
+        }
+        ::close(fd);
+        if (!valid) {
+            throw std::runtime_error(path + " does not belong to " + log_path);
+        }
+        for (size_t offset = 0; offset < slots.size(); offset += cache_slot_size) {
+            if (auto value = load_slot(slots.data() + offset)) {
+                entries.push_back(value);
+            }
+        }
+    } else if (errno != ENOENT) {
+        throw std::runtime_error("unable to open " + path + ": " + std::strerror(errno));
+    }
+    entries.insert(entries.end(), records.begin(), records.end());
+
+    uint64_t capacity = 16;
+    while (capacity < 2 * entries.size()) {
+        capacity *= 2;
+    }
+    HugeVector<unsigned char> slots(capacity * cache_slot_size);
+    size_t n_entries = 0;
+    for (auto value: entries) {
+        auto slot = const_cast<unsigned char *>(probe_slot(slots.data(), capacity, value & ~cache_winning_flag));
+        if (load_slot(slot) == 0) {
+            store_slot(slot, value);
+            ++n_entries;
+        }
+    }
+
+    CacheHeader table_header = header;
+    std::memcpy(table_header.magic, "SIRC", 4);
+    table_header.capacity = capacity;
+    table_header.n_entries = n_entries;
+    auto temporary = path + ".tmp";
+    int out = ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (out < 0) {
+        throw std::runtime_error("unable to open " + temporary + ": " + std::strerror(errno));
+    }
+    try {
+        write_all(out, &table_header, sizeof(table_header), temporary);
+        write_all(out, slots.data(), slots.size(), temporary);
+        if (::fsync(out) < 0) {
+            throw std::runtime_error("unable to write " + temporary + ": " + std::strerror(errno));
+        }
+    } catch (...) {
+        ::close(out);
+        ::unlink(temporary.c_str());
+        throw;
+    }
+    ::close(out);
+    if (std::rename(temporary.c_str(), path.c_str()) != 0) {
+        throw std::runtime_error("unable to replace " + path + ": " + std::strerror(errno));
+    }
+    if (::ftruncate(log.get(), sizeof(CacheHeader)) < 0) {
+        throw std::runtime_error("unable to empty " + log_path + ": " + std::strerror(errno));
+    }
+    return {n_entries, records.size(), capacity};
+}
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <sstream>
+#include <istream>
+#include <ostream>
+#include <vector>
+#include <stdexcept>
+
+#include "simulation.h"
+#include "game_log.h"
+#include "enumerate.h"
+
+// a regression corpus records the games a set of seeds plays, one policy and board per file:
+//   sirky-corpus 1 size 9 policy scan rng 2 layout <hex>
+//   <seed> <score> <move codes in hex, "-" for none>
+// move codes are those of the binary game log, so a line pins down every jump of its game
+constexpr int corpus_version = 1;
+
+struct CorpusGame {
+    uint64_t seed;
+    int score;
+    std::vector<uint8_t> moves;
+};
+
+struct Corpus {
+    size_t board_size;
+    Policy policy;
+    unsigned rng;
+    uint64_t layout;
+    std::vector<CorpusGame> games;
+};
+
+// throws std::runtime_error naming the line of the first problem
+inline Corpus read_corpus(std::istream &input) {
+    Corpus corpus{};
+    std::string line;
+    std::string magic, size_key, policy_key, policy, rng_key, layout_key;
+    int version;
+    if (!std::getline(input, line)) {
+        throw std::runtime_error("empty corpus");
+    }
+    std::stringstream header(line);
+    if (!(header >> magic >> version >> size_key >> corpus.board_size >> policy_key >> policy >> rng_key >>
+          corpus.rng >> layout_key >> std::hex >> corpus.layout) || magic != "sirky-corpus" || size_key != "size" ||
+        policy_key != "policy" || rng_key != "rng" || layout_key != "layout") {
+        throw std::runtime_error("not a regression corpus");
+    }
+    if (version != corpus_version) {
+        throw std::runtime_error("corpus version " + std::to_string(version) + " is not " +
+                                 std::to_string(corpus_version));
+    }
+    auto parsed = parse_policy(policy);
+    if (!parsed) {
+        throw std::runtime_error("unknown policy " + policy + " in corpus");
+    }
+    corpus.policy = *parsed;
+
+    for (size_t line_number = 2; std::getline(input, line); ++line_number) {
+        if (line.empty()) { continue; }
+        std::stringstream ss(line);
+        CorpusGame game{};
+        std::string codes;
+        if (!(ss >> game.seed >> game.score >> codes) || (codes != "-" && codes.size() % 2 != 0)) {
+            throw std::runtime_error("malformed corpus line " + std::to_string(line_number));
+        }
+        for (size_t index = 0; codes != "-" && index < codes.size(); index += 2) {
+            game.moves.push_back(uint8_t(std::stoul(codes.substr(index, 2), nullptr, 16)));
+        }
+        corpus.games.push_back(std::move(game));
+    }
+    return corpus;
+}
+
+inline void write_corpus(std::ostream &output, const Corpus &corpus) {
+    output << "sirky-corpus " << corpus_version << " size " << corpus.board_size << " policy "
+           << policy_name(corpus.policy) << " rng " << corpus.rng << " layout " << std::hex << corpus.layout
+           << std::dec << '\n';
+    static constexpr char digits[] = "0123456789abcdef";
+    for (const auto &game: corpus.games) {
+        output << game.seed << ' ' << game.score << ' ';
+        if (game.moves.empty()) {
+            output << '-';
+        }
+        for (auto code: game.moves) {
+            output << digits[code >> 4] << digits[code & 15];
+        }
+        output << '\n';
+    }
+}
+
+template<size_t size>
+uint64_t corpus_layout() {
+    return make_log_header<size>(0).layout;
+}
+
+// plays the seeds of games on n_threads workers with this build's engine and generator, filling in
+// their scores and moves
+template<size_t size>
+void play_corpus(std::vector<CorpusGame> &games, Policy policy, size_t n_threads) {
+    n_threads = std::max<size_t>(n_threads, 1);
+    run_on_threads(n_threads, [&](size_t index) {
+        std::vector<Move> moves;
+        for (size_t game = index; game < games.size(); game += n_threads) {
+            games[game].score = play_game<size>(games[game].seed, policy, moves);
+            games[game].moves.clear();
+            for (const auto &move: moves) {
+                games[game].moves.push_back(encode_move<size>(move));
+            }
+        }
+    });
+}
+
+// describes how a replayed game differs from the expected one, empty when they agree
+inline std::string corpus_mismatch(const CorpusGame &expected, const CorpusGame &played) {
+    if (expected.score == played.score && expected.moves == played.moves) {
+        return {};
+    }
+    size_t first = 0;
+    while (first < expected.moves.size() && first < played.moves.size() &&
+           expected.moves[first] == played.moves[first]) {
+        ++first;
+    }
+    std::stringstream ss;
+    ss << "seed " << expected.seed << ": expected score " << expected.score << " after "
+       << expected.moves.size() << " moves, got " << played.score << " after " << played.moves.size()
+       << " moves, first different move is number " << first + 1;
+    return ss.str();
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <atomic>
+#include <optional>
+#include <algorithm>
+#include <stdexcept>
+
+#include "bitboard.h"
+#include "evaluation.h"
+#include "symmetry.h"
+#include "enumerate.h"
+
+using PathCount = unsigned __int128;
+
+inline std::string to_decimal(PathCount value) {
+    std::string digits;
+    do {
+        digits.push_back(char('0' + int(value % 10)));
+        value /= 10;
+    } while (value);
+    return {digits.rbegin(), digits.rend()};
+}
+
+// counts the jump sequences from root to a position with target_pegs pegs, or to exactly the target
+// pattern when one is given. positions are merged level by level into one entry per symmetry orbit,
+// using only symmetries that fix the root and the target, so the count of an entry is the number of
+// paths reaching any position of its orbit. each level is spread over n_threads workers like
+// enumerate_positions; emit receives the depth, the number of orbits and the number of paths of that length
+template<size_t size, typename Emit>
+PathCount count_paths(const BitBoard<size> &root, int target_pegs, const std::optional<Target<size>> &target,
+                      size_t n_threads, Emit emit) {
+    struct Entry {
+        Bits pegs;
+        PathCount paths;
+    };
+
+    auto symmetries = target ? symmetries_fixing<size>({root.pegs, target->pattern})
+                             : symmetries_fixing<size>({root.pegs});
+    auto feasible = [&](Bits pegs) {
+        return !target || target->feasible(BitBoard<size>{pegs});
+    };
+    int depth = popcount(root.pegs) - target_pegs;
+    if (depth < 0 || !feasible(root.pegs)) {
+        return 0;
+    }
+
+    auto level = make_level(Entry{canonical<size>(root.pegs, symmetries), 1}, n_threads);
+    emit(size_t{0}, size_t{1}, PathCount{1});
+
+    for (int ply = 1; ply <= depth; ++ply) {
+        std::atomic<bool> overflow = false;
+        advance_level(level, [&](const Entry &parent, auto add) {
+            for_each_child<size>(parent.pegs, [&](Bits child) {
+                if (feasible(child)) {
+                    add({canonical<size>(child, symmetries), parent.paths});
+                }
+            });
+        }, [&](Entry &kept, const Entry &duplicate) {
+            if (__builtin_add_overflow(kept.paths, duplicate.paths, &kept.paths)) {
+                overflow = true;
+            }
+        });
+        if (overflow) {
+            throw std::overflow_error("path count does not fit in 128 bits");
+        }
+
+        size_t n_orbits = level_size(level);
+        PathCount n_paths = 0;
+        for (const auto &entries: level) {
+            for (const auto &entry: entries) {
+                if (__builtin_add_overflow(n_paths, entry.paths, &n_paths)) {
+                    throw std::overflow_error("path count does not fit in 128 bits");
+                }
+            }
+        }
+        emit(size_t(ply), n_orbits, n_paths);
+        if (n_orbits == 0) { return 0; }
+    }
+
+    PathCount total = 0;
+    for (const auto &entries: level) {
+        for (const auto &entry: entries) {
+            if (!target || entry.pegs == target->pattern) {
+                total += entry.paths;
+            }
+        }
+    }
+    return total;
+}
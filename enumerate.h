@@ -0,0 +1,127 @@
+#pragma once
+
+#include <vector>
+#include <thread>
+#include <algorithm>
+
+#include "bitboard.h"
+#include "trace.h"
+#include "numa.h"
+#include "hugepage.h"
+
+// a breadth-first level of positions split into one shard per thread by hash, each shard sorted by pegs;
+// entries carry the position in pegs plus whatever a walk over the levels accumulates
+template<typename Entry>
+using ShardedLevel = std::vector<HugeVector<Entry>>;
+
+template<typename Function>
+void run_on_threads(size_t n_threads, Function function) {
+    std::vector<std::thread> workers;
+    for (size_t index = 0; index < n_threads; ++index) {
+        workers.emplace_back([function, index, n_threads]() mutable {
+            pin_worker(index, n_threads);
+            function(index);
+        });
+    }
+    for (auto &worker: workers) {
+        worker.join();
+    }
+}
+
+template<size_t size, typename Visit>
+void for_each_child(Bits pegs, Visit visit) {
+    for (auto direction: jump_directions<size>) {
+        for (Bits sources = jump_sources(BitBoard<size>{pegs}, direction); sources; sources &= sources - 1) {
+            Bits from = sources & -sources;
+            visit(pegs ^ (from | shift(from, -direction) | shift(from, -2 * direction)));
+        }
+    }
+}
+
+// replaces level by the next one. expand(entry, add) calls add(child) for every child entry; entries for
+// the same position are folded into the first with combine(kept, duplicate). children are routed to
+// shards by hash, so every thread deduplicates its own shard without locking. shard i is always grown
+// by worker i, so with pinned workers its memory is first touched on, and stays on, that worker's node
+template<typename Entry, typename Expand, typename Combine>
+void advance_level(ShardedLevel<Entry> &level, Expand expand, Combine combine) {
+    size_t n_shards = level.size();
+    // buckets[source][shard] keeps the children each thread found for each shard
+    std::vector<ShardedLevel<Entry>> buckets(n_shards, ShardedLevel<Entry>(n_shards));
+    run_on_threads(n_shards, [&](size_t source) {
+        TraceSpan span("level expand");
+        for (const auto &entry: level[source]) {
+            expand(entry, [&](const Entry &child) {
+                buckets[source][hash_bits(child.pegs) % n_shards].push_back(child);
+            });
+        }
+    });
+    run_on_threads(n_shards, [&](size_t shard) {
+        TraceSpan span("level merge");
+        auto &entries = level[shard];
+        entries.clear();
+        for (auto &bucket: buckets) {
+            entries.insert(entries.end(), bucket[shard].begin(), bucket[shard].end());
+            HugeVector<Entry>().swap(bucket[shard]);
+        }
+        std::sort(entries.begin(), entries.end(), [](const Entry &a, const Entry &b) { return a.pegs < b.pegs; });
+        size_t kept = 0;
+        for (size_t index = 0; index < entries.size(); ++index) {
+            if (kept > 0 && entries[kept - 1].pegs == entries[index].pegs) {
+                combine(entries[kept - 1], entries[index]);
+            } else {
+                entries[kept++] = entries[index];
+            }
+        }
+        entries.resize(kept);
+    });
+}
+
+// the first level, holding only the root entry
+template<typename Entry>
+ShardedLevel<Entry> make_level(const Entry &root, size_t n_threads) {
+    ShardedLevel<Entry> level(std::max<size_t>(n_threads, 1));
+    level[hash_bits(root.pegs) % level.size()].push_back(root);
+    return level;
+}
+
+template<typename Entry>
+size_t level_size(const ShardedLevel<Entry> &level) {
+    size_t n_entries = 0;
+    for (const auto &entries: level) {
+        n_entries += entries.size();
+    }
+    return n_entries;
+}
+
+template<typename Entry>
+const Entry *find_entry(const ShardedLevel<Entry> &level, Bits pegs) {
+    const auto &entries = level[hash_bits(pegs) % level.size()];
+    auto found = std::lower_bound(entries.begin(), entries.end(), pegs,
+                                  [](const Entry &entry, Bits value) { return entry.pegs < value; });
+    return found != entries.end() && found->pegs == pegs ? &*found : nullptr;
+}
+
+// breadth-first enumeration of the distinct positions reachable after each number of jumps; emit receives
+// the depth and the number of positions at that depth until no jump is left or max_depth is reached
+template<size_t size, typename Emit>
+size_t enumerate_positions(const BitBoard<size> &root, size_t max_depth, size_t n_threads, Emit emit) {
+    struct Entry {
+        Bits pegs;
+    };
+
+    auto level = make_level(Entry{root.pegs}, n_threads);
+    size_t n_positions = 1;
+    emit(size_t{0}, size_t{1});
+
+    for (size_t depth = 1; depth <= max_depth; ++depth) {
+        advance_level(level, [](const Entry &parent, auto add) {
+            for_each_child<size>(parent.pegs, [&](Bits child) { add({child}); });
+        }, [](Entry &, const Entry &) {});
+
+        size_t count = level_size(level);
+        if (count == 0) { break; }
+        n_positions += count;
+        emit(depth, count);
+    }
+    return n_positions;
+}
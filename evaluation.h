@@ -0,0 +1,223 @@
+#pragma once
+
+#include <array>
+#include <optional>
+#include <string_view>
+#include <stdexcept>
+#include <cstdlib>
+
+#include "bitboard.h"
+
+template<size_t size>
+constexpr std::array<Bits, 3> diagonal_class_masks = {
+        make_mask<size>([](size_t row, size_t column) { return (row + column) % 3 == 0; }),
+        make_mask<size>([](size_t row, size_t column) { return (row + column) % 3 == 1; }),
+        make_mask<size>([](size_t row, size_t column) { return (row + column) % 3 == 2; }),
+};
+
+template<size_t size>
+constexpr std::array<Bits, 3> anti_diagonal_class_masks = {
+        make_mask<size>([](size_t row, size_t column) { return (row + 3 * size - column) % 3 == 0; }),
+        make_mask<size>([](size_t row, size_t column) { return (row + 3 * size - column) % 3 == 1; }),
+        make_mask<size>([](size_t row, size_t column) { return (row + 3 * size - column) % 3 == 2; }),
+};
+
+// usable cells with at most two usable neighbours: the tips of the arms and the inner elbows
+template<size_t size>
+constexpr Bits corner_mask = make_mask<size>([](size_t row, size_t column) {
+    int neighbours = 0;
+    neighbours += row > 0 && is_usable<size>(row - 1, column);
+    neighbours += row + 1 < size && is_usable<size>(row + 1, column);
+    neighbours += column > 0 && is_usable<size>(row, column - 1);
+    neighbours += column + 1 < size && is_usable<size>(row, column + 1);
+    return neighbours <= 2;
+});
+
+// a jump changes the peg count of every (r+c) mod 3 and (r-c) mod 3 class by one, so the parities
+// of n0 + n1 and n1 + n2 in both colourings never change; positions with different classes are unreachable
+// from each other
+template<size_t size>
+constexpr int position_class(Bits pegs) {
+    int result = 0;
+    for (const auto *masks: {&diagonal_class_masks<size>, &anti_diagonal_class_masks<size>}) {
+        auto n0 = popcount(pegs & (*masks)[0]);
+        auto n1 = popcount(pegs & (*masks)[1]);
+        auto n2 = popcount(pegs & (*masks)[2]);
+        result = (result << 2) | ((n0 + n1) & 1) << 1 | ((n1 + n2) & 1);
+    }
+    return result;
+}
+
+template<size_t size>
+constexpr bool can_reach(const BitBoard<size> &board, Bits target) {
+    return popcount(target) <= popcount(board.pegs) && position_class<size>(board.pegs) == position_class<size>(target);
+}
+
+// cells on which the last peg can possibly end
+template<size_t size>
+constexpr Bits reachable_finishes(const BitBoard<size> &board) {
+    Bits finishes = 0;
+    for (Bits cells = usable_mask<size>; cells; cells &= cells - 1) {
+        auto cell = cells & -cells;
+        if (can_reach(board, cell)) {
+            finishes |= cell;
+        }
+    }
+    return finishes;
+}
+
+// no search from this board can end with fewer pegs
+template<size_t size>
+constexpr int score_lower_bound(const BitBoard<size> &board) {
+    return reachable_finishes(board) ? 1 : 2;
+}
+
+template<size_t size>
+constexpr int centre_distance(size_t row, size_t column) {
+    return std::abs(int(row) - int(size / 2)) + std::abs(int(column) - int(size / 2));
+}
+
+template<size_t size>
+constexpr std::array<Bits, size> centre_distance_masks = [] {
+    std::array<Bits, size> masks{};
+    for (size_t distance = 0; distance < size; ++distance) {
+        masks[distance] = make_mask<size>([distance](size_t row, size_t column) {
+            return centre_distance<size>(row, column) == int(distance);
+        });
+    }
+    return masks;
+}();
+
+constexpr int pagoda_axis_weight(int distance) {
+    int previous = 1, current = 0;
+    for (int i = 0; i < distance; ++i) {
+        std::tie(previous, current) = std::tuple{current, previous + current};
+    }
+    return current;
+}
+
+// sum of Fibonacci weights of distance from the centre row and column; a valid pagoda function,
+// so its value never grows with a jump and pegs stranded on the arms are expensive
+template<size_t size>
+constexpr int pagoda_weight(size_t row, size_t column) {
+    return pagoda_axis_weight(std::abs(int(row) - int(size / 2))) +
+           pagoda_axis_weight(std::abs(int(column) - int(size / 2)));
+}
+
+template<size_t size>
+constexpr size_t max_pagoda_weight = 2 * pagoda_axis_weight(size / 2);
+
+template<size_t size>
+constexpr std::array<Bits, max_pagoda_weight<size> + 1> pagoda_masks = [] {
+    std::array<Bits, max_pagoda_weight<size> + 1> masks{};
+    for (size_t weight = 0; weight < masks.size(); ++weight) {
+        masks[weight] = make_mask<size>([weight](size_t row, size_t column) {
+            return pagoda_weight<size>(row, column) == int(weight);
+        });
+    }
+    return masks;
+}();
+
+template<size_t n>
+constexpr int weighted_count(Bits pegs, const std::array<Bits, n> &masks) {
+    int total = 0;
+    for (size_t weight = 1; weight < n; ++weight) {
+        total += int(weight) * popcount(pegs & masks[weight]);
+    }
+    return total;
+}
+
+// a final pattern of pegs; positions whose pagoda value already dropped below the pattern's,
+// or which have no more pegs than it without matching it, can never end on it
+template<size_t size>
+struct Target {
+    Bits pattern;
+    int pegs;
+    int pagoda;
+
+    constexpr explicit Target(Bits pattern)
+            : pattern(pattern), pegs(popcount(pattern)), pagoda(weighted_count(pattern, pagoda_masks<size>)) {}
+
+    constexpr bool reached(const BitBoard<size> &board) const {
+        return board.pegs == pattern;
+    }
+
+    constexpr bool feasible(const BitBoard<size> &board) const {
+        int board_pegs = popcount(board.pegs);
+        if (board_pegs <= pegs) { return board.pegs == pattern; }
+        return weighted_count(board.pegs, pagoda_masks<size>) >= pagoda;
+    }
+};
+
+struct Features {
+    int pegs;
+    int mobility;
+    int isolated;
+    std::array<int, 3> diagonal_classes;
+    std::array<int, 3> anti_diagonal_classes;
+    int corners;
+};
+
+template<size_t size>
+constexpr int count_moves(const BitBoard<size> &board) {
+    int moves = 0;
+    for (auto direction: jump_directions<size>) {
+        moves += popcount(jump_sources(board, direction));
+    }
+    return moves;
+}
+
+template<size_t size>
+constexpr Bits isolated_pegs(const BitBoard<size> &board) {
+    Bits neighbours = 0;
+    for (auto direction: jump_directions<size>) {
+        neighbours |= shift(board.pegs, direction);
+    }
+    return board.pegs & ~neighbours;
+}
+
+template<size_t size>
+constexpr Features get_features(const BitBoard<size> &board) {
+    Features features{};
+    features.pegs = popcount(board.pegs);
+    features.mobility = count_moves(board);
+    features.isolated = popcount(isolated_pegs(board));
+    for (size_t index = 0; index < 3; ++index) {
+        features.diagonal_classes[index] = popcount(board.pegs & diagonal_class_masks<size>[index]);
+        features.anti_diagonal_classes[index] = popcount(board.pegs & anti_diagonal_class_masks<size>[index]);
+    }
+    features.corners = popcount(board.pegs & corner_mask<size>);
+    return features;
+}
+
+enum class Heuristic {
+    MOBILITY,
+    ISOLATED,
+    PAGODA,
+    CENTRE,
+};
+
+inline std::optional<Heuristic> parse_heuristic(std::string_view name) {
+    if (name == "mobility") { return Heuristic::MOBILITY; }
+    if (name == "isolated") { return Heuristic::ISOLATED; }
+    if (name == "pagoda") { return Heuristic::PAGODA; }
+    if (name == "centre") { return Heuristic::CENTRE; }
+    return {};
+}
+
+// lower is better
+template<size_t size>
+constexpr int evaluate(const BitBoard<size> &board, Heuristic heuristic) {
+    switch (heuristic) {
+        case Heuristic::MOBILITY:
+            return -count_moves(board);
+        case Heuristic::ISOLATED:
+            return popcount(isolated_pegs(board));
+        case Heuristic::PAGODA:
+            return weighted_count(board.pegs, pagoda_masks<size>);
+        case Heuristic::CENTRE:
+            return weighted_count(board.pegs, centre_distance_masks<size>);
+        default:
+            throw std::runtime_error("unknown heuristic");
+    }
+}
@@ -0,0 +1,289 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <climits>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <optional>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <stdexcept>
+#include <algorithm>
+
+#include "bitboard.h"
+#include "trace.h"
+#include "numa.h"
+
+// set from SIGINT and SIGTERM; searches poll it and wind down, keeping what they found so far
+inline std::atomic<bool> stop_requested{false};
+inline std::atomic<int> stop_signal{0};
+
+static_assert(std::atomic<bool>::is_always_lock_free && std::atomic<int>::is_always_lock_free,
+              "the stop flag is written from a signal handler");
+
+inline void request_stop(int signal) {
+    stop_signal.store(signal, std::memory_order_relaxed);
+    stop_requested.store(true, std::memory_order_relaxed);
+}
+
+inline void install_stop_handlers() {
+    struct sigaction action{};
+    action.sa_handler = request_stop;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGINT, &action, nullptr);
+    sigaction(SIGTERM, &action, nullptr);
+}
+
+enum class FindEnd {
+    FOUND,
+    BUDGET,
+    STOPPED,
+};
+
+// find plays the seeds first_seed, first_seed + 1, ... in blocks; every block below next_seed has been
+// played completely, so a search resumed from next_seed neither skips nor repeats a game
+struct FindProgress {
+    uint64_t first_seed = 0;
+    uint64_t next_seed = 0;
+    size_t n_games = 0;
+    int best_score = INT_MAX;
+    uint64_t best_seed = 0;
+    std::optional<uint64_t> winning_seed;
+    std::vector<size_t> histogram;
+};
+
+// identifies what a checkpoint searched for; resuming with different settings would mix two searches
+struct FindSettings {
+    size_t board_size;
+    int policy;
+    int rng_version;
+    int target_score;
+    std::string target;
+
+    bool operator==(const FindSettings &) const = default;
+};
+
+// plain text so a checkpoint can be inspected and edited by hand; written to a temporary file and
+// renamed, so a kill while saving leaves the previous checkpoint intact
+inline void save_checkpoint(const std::string &path, const FindSettings &settings, const FindProgress &progress) {
+    TraceSpan span("checkpoint");
+    auto temporary = path + ".tmp";
+    {
+        std::ofstream file(temporary, std::ios::trunc);
+        file << "sirky-find-checkpoint 1\n"
+             << "board_size " << settings.board_size << '\n'
+             << "policy " << settings.policy << '\n'
+             << "rng_version " << settings.rng_version << '\n'
+             << "target_score " << settings.target_score << '\n'
+             << "target " << (settings.target.empty() ? "-" : settings.target) << '\n'
+             << "first_seed " << progress.first_seed << '\n'
+             << "next_seed " << progress.next_seed << '\n'
+             << "games " << progress.n_games << '\n'
+             << "best_score " << progress.best_score << '\n'
+             << "best_seed " << progress.best_seed << '\n'
+             << "winning_seed " << (progress.winning_seed ? std::to_string(*progress.winning_seed) : "-") << '\n'
+             << "histogram";
+        for (auto count: progress.histogram) {
+            file << ' ' << count;
+        }
+        file << '\n';
+        if (!file.flush()) {
+            throw std::runtime_error("unable to write checkpoint " + temporary);
+        }
+    }
+    if (std::rename(temporary.c_str(), path.c_str()) != 0) {
+        throw std::runtime_error("unable to replace checkpoint " + path);
+    }
+}
+
+// empty if there is no checkpoint yet; throws if it is unreadable or was written for other settings
+inline std::optional<FindProgress> load_checkpoint(const std::string &path, const FindSettings &settings) {
+    std::ifstream file(path);
+    if (!file) {
+        return {};
+    }
+    auto fail = [&](const std::string &reason) {
+        return std::runtime_error("checkpoint " + path + " " + reason);
+    };
+
+    std::string magic;
+    int version;
+    if (!(file >> magic >> version) || magic != "sirky-find-checkpoint" || version != 1) {
+        throw fail("is not a find checkpoint of version 1");
+    }
+    FindSettings saved;
+    FindProgress progress;
+    std::string key, winning_seed;
+    std::string line;
+    std::getline(file, line);
+    while (std::getline(file, line)) {
+        std::stringstream fields(line);
+        fields >> key;
+        bool parsed;
+        if (key == "board_size") { parsed = bool(fields >> saved.board_size); }
+        else if (key == "policy") { parsed = bool(fields >> saved.policy); }
+        else if (key == "rng_version") { parsed = bool(fields >> saved.rng_version); }
+        else if (key == "target_score") { parsed = bool(fields >> saved.target_score); }
+        else if (key == "target") { parsed = bool(fields >> saved.target); }
+        else if (key == "first_seed") { parsed = bool(fields >> progress.first_seed); }
+        else if (key == "next_seed") { parsed = bool(fields >> progress.next_seed); }
+        else if (key == "games") { parsed = bool(fields >> progress.n_games); }
+        else if (key == "best_score") { parsed = bool(fields >> progress.best_score); }
+        else if (key == "best_seed") { parsed = bool(fields >> progress.best_seed); }
+        else if (key == "winning_seed") { parsed = bool(fields >> winning_seed); }
+        else if (key == "histogram") {
+            for (size_t count; fields >> count;) {
+                progress.histogram.push_back(count);
+            }
+            parsed = fields.eof();
+        } else {
+            throw fail("has unknown entry " + key);
+        }
+        if (!parsed) {
+            throw fail("has a malformed " + key + " entry");
+        }
+    }
+    if (saved.target == "-") {
+        saved.target.clear();
+    }
+    if (!(saved == settings)) {
+        throw fail("was written for another board size, policy, RNG version or target");
+    }
+    if (!winning_seed.empty() && winning_seed != "-") {
+        progress.winning_seed = std::stoull(winning_seed);
+    }
+    return progress;
+}
+
+// plays seeds on n_threads workers until play reports a success, the game budget or time limit is used
+// up or a stop is requested. play(seed, moves) returns whether the game succeeded and leaves its moves;
+// record(seed, score, moves) sees every success; report(progress) is called from the calling thread
+// every report_interval games. scores are counted from the number of jumps, each of which removes a peg
+template<typename Play, typename Record, typename Report>
+FindEnd find_games(FindProgress &progress, int start_pegs, Play play, Record record, Report report,
+                   size_t n_threads, size_t max_games, std::optional<double> time_limit,
+                   size_t report_interval = 100000, size_t block_size = 256) {
+    n_threads = std::max<size_t>(n_threads, 1);
+    progress.histogram.resize(start_pegs + 1);
+    if (progress.winning_seed) {
+        return FindEnd::FOUND;
+    }
+
+    std::mutex mutex;
+    std::condition_variable changed;
+    bool done = false;
+    bool paused = false;
+    // the game budget counts this run only, not the games of a resumed checkpoint
+    size_t n_finished_before = progress.n_games;
+    size_t n_claimed = 0;
+    size_t n_running = n_threads;
+
+    std::vector<std::thread> workers;
+    for (size_t index = 0; index < n_threads; ++index) {
+        workers.emplace_back([&, index] {
+            pin_worker(index, n_threads);
+            std::vector<Move> moves;
+            std::vector<size_t> histogram(start_pegs + 1);
+            std::vector<std::pair<uint64_t, std::vector<Move>>> successes;
+            while (true) {
+                std::unique_lock lock(mutex);
+                {
+                    TraceSpan span("find claim");
+                    changed.wait(lock, [&] { return !paused || done; });
+                }
+                if (done || n_claimed >= max_games) {
+                    break;
+                }
+                auto n_block = std::min<size_t>(block_size, max_games - n_claimed);
+                auto first = progress.next_seed;
+                progress.next_seed += n_block;
+                n_claimed += n_block;
+                lock.unlock();
+
+                TraceSpan span("find block");
+                std::fill(histogram.begin(), histogram.end(), 0);
+                successes.clear();
+                int best_score = INT_MAX;
+                uint64_t best_seed = 0;
+                for (auto seed = first; seed < first + n_block; ++seed) {
+                    bool success = play(seed, moves);
+                    int score = start_pegs - int(moves.size());
+                    ++histogram[score];
+                    if (score < best_score) {
+                        best_score = score;
+                        best_seed = seed;
+                    }
+                    if (success) {
+                        successes.emplace_back(seed, moves);
+                    }
+                }
+
+                lock.lock();
+                progress.n_games += n_block;
+                for (size_t score = 0; score < histogram.size(); ++score) {
+                    progress.histogram[score] += histogram[score];
+                }
+                if (best_score < progress.best_score) {
+                    progress.best_score = best_score;
+                    progress.best_seed = best_seed;
+                }
+                for (const auto &[seed, success_moves]: successes) {
+                    record(seed, start_pegs - int(success_moves.size()), success_moves);
+                    if (!progress.winning_seed || seed < *progress.winning_seed) {
+                        progress.winning_seed = seed;
+                    }
+                    done = true;
+                }
+                changed.notify_all();
+            }
+            std::lock_guard lock(mutex);
+            --n_running;
+            changed.notify_all();
+        });
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    bool timed_out = false;
+    size_t next_report = (progress.n_games / report_interval + 1) * report_interval;
+    {
+        std::unique_lock lock(mutex);
+        while (n_running > 0) {
+            changed.wait_for(lock, std::chrono::milliseconds(100));
+            if (stop_requested.load(std::memory_order_relaxed)) {
+                done = true;
+            }
+            if (time_limit &&
+                std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() >= *time_limit) {
+                timed_out = !done;
+                done = true;
+            }
+            if (progress.n_games >= next_report && n_running > 0) {
+                // let the blocks in flight finish so the reported progress covers a gapless range of seeds
+                TraceSpan span("find pause");
+                paused = true;
+                changed.wait(lock, [&] { return progress.n_games - n_finished_before == n_claimed; });
+                auto snapshot = progress;
+                paused = false;
+                changed.notify_all();
+                next_report = (progress.n_games / report_interval + 1) * report_interval;
+                lock.unlock();
+                report(snapshot);
+                lock.lock();
+            }
+        }
+    }
+    for (auto &worker: workers) {
+        worker.join();
+    }
+
+    if (progress.winning_seed) { return FindEnd::FOUND; }
+    if (timed_out || n_claimed >= max_games) { return FindEnd::BUDGET; }
+    return FindEnd::STOPPED;
+}
@@ -0,0 +1,219 @@
+#pragma once
+
+#include <cstdint>
+#include <cerrno>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <span>
+#include <optional>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "bitboard.h"
+#include "rng.h"
+
+constexpr uint8_t log_version = 1;
+// bumped whenever the seed to game mapping changes, and distinct for each generator
+constexpr uint8_t rng_version = Random::version;
+
+struct LogHeader {
+    char magic[4];
+    uint8_t version;
+    uint8_t board_size;
+    uint8_t rng_version;
+    uint8_t policy;
+    uint64_t layout;
+};
+
+static_assert(sizeof(LogHeader) == 16);
+
+// record: 8 byte little endian seed, score byte, move count byte, one byte per move
+constexpr size_t record_header_size = 10;
+
+// a jump is identified by the jumped-over cell and its axis; the board decides which side it came from
+template<size_t size>
+uint8_t encode_move(const Move &move) {
+    static_assert(size * size <= 128, "cell index must fit in seven bits");
+    auto [from_row, from_column] = move.from;
+    auto [to_row, to_column] = move.to;
+    auto over = ((from_row + to_row) / 2) * size + (from_column + to_column) / 2;
+    return uint8_t(over << 1 | (from_row != to_row));
+}
+
+template<size_t size>
+std::optional<Move> decode_move(const BitBoard<size> &board, uint8_t code) {
+    size_t over = code >> 1;
+    size_t row = over / size;
+    size_t column = over % size;
+    bool vertical = code & 1;
+    if (row >= size || (vertical ? (row == 0 || row == size - 1) : (column == 0 || column == size - 1))) {
+        return {};
+    }
+
+    Coordinate before = vertical ? Coordinate{row - 1, column} : Coordinate{row, column - 1};
+    Coordinate after = vertical ? Coordinate{row + 1, column} : Coordinate{row, column + 1};
+    auto occupied = [&](const Coordinate &cell) {
+        auto [cell_row, cell_column] = cell;
+        return (board.pegs & cell_bit<size>(cell_row, cell_column)) != 0;
+    };
+    auto empty = [&](const Coordinate &cell) {
+        auto [cell_row, cell_column] = cell;
+        return (board.empty() & cell_bit<size>(cell_row, cell_column)) != 0;
+    };
+
+    if (!occupied({row, column})) { return {}; }
+    if (occupied(before) && empty(after)) { return Move{before, after}; }
+    if (occupied(after) && empty(before)) { return Move{after, before}; }
+    return {};
+}
+
+template<size_t size>
+LogHeader make_log_header(uint8_t policy) {
+    LogHeader header{{'S', 'I', 'R', 'K'}, log_version, uint8_t(size), rng_version, policy,
+                     hash_bits(usable_mask<size>)};
+    return header;
+}
+
+template<size_t size>
+class GameLogWriter {
+public:
+    GameLogWriter(const std::string &path, uint8_t policy, size_t buffer_size = 1 << 20) {
+        fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) {
+            throw std::runtime_error("unable to open " + path + ": " + std::strerror(errno));
+        }
+        buffer.reserve(buffer_size);
+        auto header = make_log_header<size>(policy);
+        append(&header, sizeof(header));
+    }
+
+    GameLogWriter(const GameLogWriter &) = delete;
+    GameLogWriter &operator=(const GameLogWriter &) = delete;
+
+    ~GameLogWriter() {
+        flush();
+        ::close(fd);
+    }
+
+    void write(uint64_t seed, int score, const std::vector<Move> &moves) {
+        uint8_t record[record_header_size];
+        for (size_t index = 0; index < 8; ++index) {
+            record[index] = uint8_t(seed >> (8 * index));
+        }
+        record[8] = uint8_t(score);
+        record[9] = uint8_t(moves.size());
+        append(record, sizeof(record));
+        for (const auto &move: moves) {
+            auto code = encode_move<size>(move);
+            append(&code, 1);
+        }
+        ++n_records;
+    }
+
+    void flush() {
+        const char *data = buffer.data();
+        size_t remaining = buffer.size();
+        while (remaining > 0) {
+            auto written = ::write(fd, data, remaining);
+            if (written < 0) {
+                if (errno == EINTR) { continue; }
+                throw std::runtime_error(std::string("unable to write game log: ") + std::strerror(errno));
+            }
+            data += written;
+            remaining -= written;
+        }
+        buffer.clear();
+    }
+
+    size_t records() const {
+        return n_records;
+    }
+
+private:
+    void append(const void *data, size_t length) {
+        if (buffer.size() + length > buffer.capacity()) {
+            flush();
+        }
+        auto bytes = static_cast<const char *>(data);
+        buffer.insert(buffer.end(), bytes, bytes + length);
+    }
+
+    int fd;
+    std::vector<char> buffer;
+    size_t n_records = 0;
+};
+
+struct GameRecord {
+    uint64_t seed;
+    int score;
+    std::span<const uint8_t> moves;
+};
+
+class GameLogReader {
+public:
+    explicit GameLogReader(const std::string &path) {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw std::runtime_error("unable to open " + path + ": " + std::strerror(errno));
+        }
+        struct stat status{};
+        if (::fstat(fd, &status) < 0 || size_t(status.st_size) < sizeof(LogHeader)) {
+            ::close(fd);
+            throw std::runtime_error(path + " is not a game log");
+        }
+        length = status.st_size;
+        mapping = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (mapping == MAP_FAILED) {
+            throw std::runtime_error("unable to map " + path + ": " + std::strerror(errno));
+        }
+        ::madvise(mapping, length, MADV_SEQUENTIAL);
+
+        std::memcpy(&log_header, mapping, sizeof(log_header));
+        if (std::memcmp(log_header.magic, "SIRK", 4) != 0 || log_header.version != log_version) {
+            ::munmap(mapping, length);
+            throw std::runtime_error(path + " is not a game log of version " + std::to_string(log_version));
+        }
+        cursor = static_cast<const uint8_t *>(mapping) + sizeof(LogHeader);
+        end = static_cast<const uint8_t *>(mapping) + length;
+    }
+
+    GameLogReader(const GameLogReader &) = delete;
+    GameLogReader &operator=(const GameLogReader &) = delete;
+
+    ~GameLogReader() {
+        ::munmap(mapping, length);
+    }
+
+    const LogHeader &header() const {
+        return log_header;
+    }
+
+    // false at the end of the log; throws on a truncated record
+    bool next(GameRecord &record) {
+        if (cursor == end) { return false; }
+        if (size_t(end - cursor) < record_header_size || size_t(end - cursor) < record_header_size + cursor[9]) {
+            throw std::runtime_error("truncated game log record");
+        }
+        record.seed = 0;
+        for (size_t index = 0; index < 8; ++index) {
+            record.seed |= uint64_t(cursor[index]) << (8 * index);
+        }
+        record.score = cursor[8];
+        record.moves = {cursor + record_header_size, cursor[9]};
+        cursor += record_header_size + cursor[9];
+        return true;
+    }
+
+private:
+    void *mapping;
+    size_t length;
+    LogHeader log_header;
+    const uint8_t *cursor;
+    const uint8_t *end;
+};
@@ -0,0 +1,137 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <new>
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <algorithm>
+
+#include <sys/mman.h>
+
+// large tables (search levels, trees, trails) are allocated in 2 MiB pages where the system allows, as
+// their random probes miss the TLB on 4 KiB pages. allocations try explicit huge pages from the
+// hugetlb pool first, then transparent huge pages requested with madvise, then plain pages
+enum class PageKind {
+    HUGETLB,
+    TRANSPARENT,
+    REGULAR,
+};
+
+constexpr size_t huge_page_size = size_t{2} << 20;
+// smaller allocations come from operator new, where rounding up to a huge page would waste memory
+constexpr size_t huge_page_threshold = size_t{4} << 20;
+
+struct HugePageStats {
+    std::mutex mutex;
+    size_t n_allocations[3] = {};
+    size_t live_bytes = 0;
+    size_t peak_bytes = 0;
+};
+
+inline HugePageStats &huge_page_stats() {
+    static HugePageStats stats;
+    return stats;
+}
+
+// false when the kernel lacks transparent huge pages or they are switched off
+inline bool transparent_huge_pages_available() {
+    static const bool available = [] {
+        std::ifstream file("/sys/kernel/mm/transparent_hugepage/enabled");
+        std::string modes;
+        return std::getline(file, modes) && modes.find("[never]") == std::string::npos;
+    }();
+    return available;
+}
+
+inline size_t huge_page_length(size_t bytes) {
+    return (bytes + huge_page_size - 1) / huge_page_size * huge_page_size;
+}
+
+inline void *allocate_huge(size_t bytes) {
+    size_t length = huge_page_length(bytes);
+    auto kind = PageKind::HUGETLB;
+    void *memory = ::mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (memory == MAP_FAILED) {
+        // over-map by a huge page and trim, so the range is aligned for transparent huge pages
+        auto mapping = static_cast<char *>(::mmap(nullptr, length + huge_page_size, PROT_READ | PROT_WRITE,
+                                                  MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+        if (mapping == MAP_FAILED) {
+            throw std::bad_alloc();
+        }
+        auto offset = (huge_page_size - reinterpret_cast<uintptr_t>(mapping) % huge_page_size) % huge_page_size;
+        if (offset) {
+            ::munmap(mapping, offset);
+        }
+        ::munmap(mapping + offset + length, huge_page_size - offset);
+        memory = mapping + offset;
+        bool advised = transparent_huge_pages_available() && ::madvise(memory, length, MADV_HUGEPAGE) == 0;
+        kind = advised ? PageKind::TRANSPARENT : PageKind::REGULAR;
+    }
+
+    auto &stats = huge_page_stats();
+    std::lock_guard lock(stats.mutex);
+    ++stats.n_allocations[int(kind)];
+    stats.live_bytes += length;
+    stats.peak_bytes = std::max(stats.peak_bytes, stats.live_bytes);
+    return memory;
+}
+
+inline void free_huge(void *memory, size_t bytes) {
+    size_t length = huge_page_length(bytes);
+    ::munmap(memory, length);
+    auto &stats = huge_page_stats();
+    std::lock_guard lock(stats.mutex);
+    stats.live_bytes -= length;
+}
+
+// which pages the large allocations so far got, empty when there were none
+inline std::string huge_page_report() {
+    auto &stats = huge_page_stats();
+    std::lock_guard lock(stats.mutex);
+    auto [hugetlb, transparent, regular] = stats.n_allocations;
+    if (hugetlb + transparent + regular == 0) {
+        return {};
+    }
+    std::stringstream ss;
+    ss << "Large tables peaked at " << (stats.peak_bytes >> 20) << " MiB in " << hugetlb
+       << " allocations of hugetlb pages, " << transparent << " of transparent huge pages and " << regular
+       << " of 4 KiB pages.";
+    return ss.str();
+}
+
+template<typename T>
+struct HugePageAllocator {
+    using value_type = T;
+
+    HugePageAllocator() = default;
+
+    template<typename U>
+    HugePageAllocator(const HugePageAllocator<U> &) {}
+
+    T *allocate(size_t n) {
+        if (n * sizeof(T) < huge_page_threshold) {
+            return static_cast<T *>(::operator new(n * sizeof(T)));
+        }
+        return static_cast<T *>(allocate_huge(n * sizeof(T)));
+    }
+
+    void deallocate(T *memory, size_t n) {
+        if (n * sizeof(T) < huge_page_threshold) {
+            ::operator delete(memory);
+        } else {
+            free_huge(memory, n * sizeof(T));
+        }
+    }
+
+    template<typename U>
+    bool operator==(const HugePageAllocator<U> &) const {
+        return true;
+    }
+};
+
+template<typename T>
+using HugeVector = std::vector<T, HugePageAllocator<T>>;
@@ -1,282 +1,767 @@
 #include <iostream>
-#include <array>
-#include <optional>
-#include <tuple>
-#include <cassert>
-#include <vector>
-#include <numeric>
-#include <ranges>
-#include <thread>
-#include <chrono>
 #include <sstream>
+#include <fstream>
+#include <climits>
+#include <ctime>
+#include <chrono>
+#include <type_traits>
+
+#include "simulation.h"
+#include "mcts.h"
+#include "beam.h"
+#include "solver.h"
+#include "cache.h"
+#include "game_log.h"
+#include "batch.h"
+#include "verify.h"
+#include "bench.h"
+#include "perf.h"
+#include "numa.h"
+#include "hugepage.h"
+#include "enumerate.h"
+#include "count.h"
+#include "winrate.h"
+#include "corpus.h"
+#include "options.h"
+#include "find.h"
+
+void print_search_result(const SearchResult &result) {
+    std::cout << "Ended with " << result.score << " matches remaining";
+    if (result.n_playouts) {
+        std::cout << " after " << result.n_playouts << " playouts";
+    }
+    std::cout << ". Took " << result.moves.size() << " moves:\n";
+    const char *sep = "";
+    for (const auto &move: result.moves) {
+        std::cout << sep << move;
+        sep = " ; ";
+    }
+    std::cout << '\n';
+}
 
-enum class FieldState {
-    UNUSABLE,
-    EMPTY,
-    OCCUPIED,
-};
+void print_usage(const char *program) {
+    std::cerr << "usage: " << program << R"( <command> [seed|file...] [options]
+
+    commands:
+        find            play random games of consecutive seeds until one
+                        reaches the target score (or ends on --target);
+                        SIGINT and SIGTERM stop it, printing the best
+                        seed and score histogram so far
+        simulate        simulate a game from given seed, or every seed
+                        of a --seeds list
+        mcts            UCT tree search using random playouts as rollouts
+        nmcs            nested Monte Carlo search over random playouts
+        beam            beam search keeping the best positions at each ply
+        targets         show the cells the last peg can possibly end on
+        solve           depth-first search for a game ending on --target
+        enumerate       count the distinct positions reachable after
+                        each number of jumps
+        count           count the jump sequences ending on the target
+                        score (or on --target), merging symmetric
+                        positions level by level
+        winrate         probability that a playout ends on the target
+                        score, sampled from --max-games games (default
+                        1000000) with confidence intervals and, with
+                        --exact, computed over every reachable position;
+                        split by first jump and by depth
+        compact         merge the log of a solved-position cache into its
+                        table
+        replay          print and check the games of a binary game log
+        verify          check games against the rules in parallel, either
+                        a binary game log or text with one game per line
+                        in the "(r, c) ~> (r, c) ; ..." format
+        bench           time playouts of a fixed set of seeds
+        regress         replay the seeds of regression corpus files and
+                        check their scores and moves; --regenerate
+                        rewrites them instead, reporting throughput
 
-template<size_t size>
-using Board = std::array<std::array<FieldState, size>, size>;
+    arguments:
+        seed            seed of the game for "simulate", 0 for a random
+                        seed.
+        file            binary game log read by "replay", games read by
+                        "verify" ("-" for text on standard input), or
+                        the solved-position cache "compact" rewrites;
+                        "regress" takes any number of corpus files.
+
+    options:
+        --size n        board size 5, 7 or 9 (default); logs read by
+                        "replay" and "verify" carry their own size.
+        --threads n     worker threads of "find", "simulate --seeds",
+                        "beam", "enumerate", "count", "winrate", "verify"
+                        and "regress", defaults to the number of hardware
+                        threads.
+        --policy name   move choice of playouts for "find", "simulate",
+                        "mcts", "nmcs" and "winrate": scan (default),
+                        uniform, mobility, edge, softmax or epsilon. for
+                        "solve" it orders moves, defaulting to mobility;
+                        for "bench" it times only that policy; for
+                        "regress" the policy of a new corpus.
+        --target-score n
+                        score at which "find", "mcts" and "nmcs" stop,
+                        "count" counts and "winrate" wins, defaults to
+                        the lowest reachable score.
+        --time-limit s  stop "find" after s seconds.
+        --max-games n   stop "find" after n games; for "bench" the
+                        number of games per policy, for "winrate" the
+                        number of sampled games, for "regress" the
+                        number of seeds of a new corpus (default 100).
+        --checkpoint file
+                        progress of "find", rewritten every 100000 games
+                        and on exit; an existing checkpoint is resumed
+                        from its next unplayed seed.
+        --out file      write a binary game log; "find" logs every game
+                        reaching the target score (or ending on its
+                        target), "solve" logs its solution and
+                        "simulate --seeds" logs every game.
+        --target cells  final pattern of pegs for "find", "solve" and
+                        "count", cells as row,column joined by "+", e.g.
+                        4,4+4,1.
+        --cache file    solved-position cache of "solve", one per board
+                        and target: positions proven by earlier runs are
+                        not searched again and new proofs are appended to
+                        file.log, which "compact" merges into file.
+        --seeds file    simulate every seed listed in file ("-" for
+                        standard input) in parallel, printing seed,
+                        score and move count per line in input order.
+        --heuristic h   ranking used by "beam", one of mobility (default),
+                        isolated, pagoda or centre.
+        --playouts n    playout budget for "mcts", defaults to 1000000.
+        --level n       nesting level for "nmcs", defaults to 2.
+        --width n       beam width for "beam", defaults to 1000.
+        --depth n       number of jumps "enumerate" looks ahead, all of
+                        them by default.
+        --exact         also compute the exact probabilities of "winrate";
+                        only for the scan and uniform policies.
+        --fps rate      frames per second of the "simulate" animation,
+                        defaults to 2; 0 draws as fast as possible.
+        --no-animate    print every board of "simulate" one after another
+                        instead of animating in place; the default when
+                        output is not a terminal.
+        --summary       print only the result of "simulate".
+        --pin           bind each worker thread to one CPU, spreading them
+                        over the NUMA nodes in contiguous ranges, so the
+                        level shards of "enumerate", "count" and
+                        "winrate" stay on the node of the worker that
+                        fills them.
+        --perf          read hardware counters of "find" and "bench" with
+                        perf_event_open, per game and per move; "bench"
+                        also splits scan playouts into rng, move
+                        generation and move application. counters the
+                        kernel or CPU do not offer are skipped.
+        --trace file    write the spans of worker threads (find blocks and
+                        checkpoints, search levels, batches, cache
+                        flushes) as Chrome trace JSON for Perfetto; only
+                        in builds configured with -DSIRKY_TRACE=ON.
+        --regenerate    rewrite the corpus files of "regress" with the
+                        games this build plays.
+)" << '\n';
+}
 
 template<size_t size>
-Board<size> make_board() {
-    static_assert(size % 2 == 1, "Board size must be odd.");
-
-    Board<size> board = {};
-    for (auto &row: board) {
-        for (auto &cell: row) {
-            cell = FieldState::OCCUPIED;
+std::optional<Bits> parse_target(const std::string &text) {
+    Bits pattern = 0;
+    std::stringstream ss(text);
+    std::string cell;
+    while (std::getline(ss, cell, '+')) {
+        std::stringstream cell_stream(cell);
+        size_t row, column;
+        char separator;
+        if (!(cell_stream >> row >> separator >> column) || separator != ',' || row >= size ||
+            column >= size || !is_usable<size>(row, column)) {
+            return {};
         }
+        pattern |= cell_bit<size>(row, column);
     }
-
-    for (auto index: std::array<size_t, 2>{{0, size - 1}}) {
-        board[index][0] = FieldState::UNUSABLE;
-        board[index][1] = FieldState::UNUSABLE;
-        board[index][size - 2] = FieldState::UNUSABLE;
-        board[index][size - 1] = FieldState::UNUSABLE;
+    if (!pattern) {
+        return {};
     }
+    return pattern;
+}
 
-    for (auto index: std::array<size_t, 2>{1, size - 2}) {
-        board[index][0] = FieldState::UNUSABLE;
-        board[index][size - 1] = FieldState::UNUSABLE;
+// calls function with the board size as a compile time constant
+template<typename Function>
+int with_board_size(size_t size, Function function) {
+    switch (size) {
+        case 5:
+            return function(std::integral_constant<size_t, 5>{});
+        case 7:
+            return function(std::integral_constant<size_t, 7>{});
+        case 9:
+            return function(std::integral_constant<size_t, 9>{});
+        default:
+            std::cerr << "unsupported board size " << size << '\n';
+            return 1;
     }
+}
 
-    board[size / 2][size / 2] = FieldState::EMPTY;
-    return board;
+bool check_log_layout(const std::string &path, const LogHeader &header) {
+    return with_board_size(header.board_size, [&](auto size) {
+        if (header.layout != make_log_header<size>(0).layout) {
+            std::cerr << path << " was written for a different board layout\n";
+            return 1;
+        }
+        return 0;
+    }) == 0;
 }
 
 template<size_t size>
-std::ostream &operator<<(std::ostream &os, const Board<size> &board) {
-
-    for (const auto &row: board) {
-        for (const auto &cell: row) {
-            switch (cell) {
-                case FieldState::UNUSABLE:
-                    os << ' ';
-                    break;
-                case FieldState::EMPTY:
-                    os << '.';
-                    break;
-                case FieldState::OCCUPIED:
-                    os << '@';
-                    break;
-                default:
-                    throw std::runtime_error("unknown cell type");
+int replay_log(GameLogReader &reader) {
+    GameRecord record{};
+    size_t n_records = 0;
+    while (reader.next(record)) {
+        auto board = start_board<size>;
+        std::cout << "Seed " << record.seed << ", " << record.score << " matches remaining, "
+                  << record.moves.size() << " moves:\n";
+        const char *sep = "";
+        for (auto code: record.moves) {
+            auto move = decode_move(board, code);
+            if (!move) {
+                std::cout << '\n';
+                std::cerr << "illegal move in game " << n_records << '\n';
+                return 1;
             }
+            do_move(board, *move);
+            std::cout << sep << *move;
+            sep = " ; ";
+        }
+        std::cout << '\n';
+        if (popcount(board.pegs) != record.score) {
+            std::cerr << "game " << n_records << " ends with " << popcount(board.pegs) << " pegs, not "
+                      << record.score << '\n';
+            return 1;
         }
-        os << '\n';
+        ++n_records;
     }
+    std::cout << "Replayed " << n_records << " games.\n";
+    return 0;
+}
 
-    return os;
+int replay_log(const std::string &path) {
+    GameLogReader reader(path);
+    const auto &header = reader.header();
+    if (!check_log_layout(path, header)) {
+        return 1;
+    }
+    if (header.rng_version != rng_version) {
+        std::cerr << "warning: " << path << " was written with RNG version " << int(header.rng_version)
+                  << ", seeds will not reproduce its games\n";
+    }
+    return with_board_size(header.board_size, [&](auto size) { return replay_log<size>(reader); });
 }
 
-using Coordinate = std::tuple<size_t, size_t>;
+// text games are read for the board size of the options, binary logs for the size in their header
+int verify_games(const std::string &path, size_t board_size, size_t n_threads) {
+    std::ios::sync_with_stdio(false);
+    size_t n_rejected = 0;
+    auto report = [&](const Verdict &verdict) {
+        if (!verdict.error.empty()) {
+            std::cout << "game " << verdict.game << ": " << verdict.error << '\n';
+            ++n_rejected;
+        }
+    };
+
+    size_t n_games;
+    char magic[4] = {};
+    std::ifstream file;
+    if (path != "-") {
+        file.open(path, std::ios::binary);
+        if (!file) {
+            std::cerr << "unable to open " << path << '\n';
+            return 1;
+        }
+        file.read(magic, sizeof(magic));
+        file.seekg(0);
+    }
+    if (std::string_view(magic, sizeof(magic)) == "SIRK") {
+        GameLogReader reader(path);
+        if (!check_log_layout(path, reader.header())) {
+            return 1;
+        }
+        with_board_size(reader.header().board_size, [&](auto size) {
+            n_games = verify_log<size>(reader, n_threads, report);
+            return 0;
+        });
+    } else {
+        with_board_size(board_size, [&](auto size) {
+            n_games = verify_text_stream<size>(path == "-" ? std::cin : file, n_threads, report);
+            return 0;
+        });
+    }
+    std::cout << "Verified " << n_games << " games, " << n_rejected << " rejected.\n";
+    return n_rejected ? 1 : 0;
+}
 
-struct Move {
-    Coordinate from;
-    Coordinate to;
-};
+// checks the games of a regression corpus against this build, or rewrites them with --regenerate; a
+// corpus that does not exist yet is generated for seeds 1..--max-games with --policy and --size
+int regress_corpus(const std::string &path, const Options &options) {
+    Corpus corpus{};
+    std::ifstream file(path);
+    if (file) {
+        try {
+            corpus = read_corpus(file);
+        } catch (const std::runtime_error &error) {
+            std::cerr << path << ": " << error.what() << '\n';
+            return 1;
+        }
+    } else if (options.regenerate) {
+        corpus.board_size = options.size;
+        corpus.policy = options.policy.value_or(Policy::SCAN);
+        for (size_t seed = 1; seed <= options.max_games.value_or(100); ++seed) {
+            corpus.games.push_back({seed, 0, {}});
+        }
+    } else {
+        std::cerr << "unable to open " << path << '\n';
+        return 1;
+    }
+    file.close();
+    if (!options.regenerate && corpus.rng != rng_version) {
+        std::cerr << path << " was generated with RNG version " << corpus.rng << ", this build uses "
+                  << int(rng_version) << '\n';
+        return 1;
+    }
 
+    return with_board_size(corpus.board_size, [&](auto size) {
+        if (!options.regenerate && corpus.layout != corpus_layout<size>()) {
+            std::cerr << path << " was generated for a different board layout\n";
+            return 1;
+        }
+        auto played = corpus.games;
+        auto start = std::chrono::steady_clock::now();
+        play_corpus<size>(played, corpus.policy, options.threads);
+        auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        size_t n_moves = 0;
+        size_t n_changed = 0;
+        for (size_t index = 0; index < played.size(); ++index) {
+            n_moves += played[index].moves.size();
+            auto mismatch = corpus_mismatch(corpus.games[index], played[index]);
+            if (!mismatch.empty()) {
+                ++n_changed;
+                if (!options.regenerate) {
+                    std::cout << path << ": " << mismatch << '\n';
+                }
+            }
+        }
+        std::cout << path << ": " << played.size() << " " << policy_name(corpus.policy) << " games in " << seconds
+                  << " s, " << played.size() / seconds << " games/s, " << n_moves / seconds << " moves/s, "
+                  << n_changed << (options.regenerate ? " changed" : " mismatched") << '\n';
+        if (!options.regenerate) {
+            return n_changed ? 1 : 0;
+        }
 
-std::ostream &operator<<(std::ostream &os, const Move &move) {
-    auto [from_row, from_column] = move.from;
-    auto [to_row, to_column] = move.to;
-    os << "(" << from_row << ", " << from_column << ") ~> (" << to_row << ", " << to_column << ")";
-    return os;
+        corpus.games = std::move(played);
+        corpus.rng = rng_version;
+        corpus.layout = corpus_layout<size>();
+        std::ofstream out(path);
+        write_corpus(out, corpus);
+        if (!out.flush()) {
+            std::cerr << "unable to write " << path << '\n';
+            return 1;
+        }
+        return 0;
+    });
 }
 
-template<size_t size>
-std::optional<FieldState> get_from_board(const Board<size> &board, int row, int column) {
-    if (row < 0 || column < 0 || row >= size || column >= size) {
-        return {};
+void print_huge_page_report() {
+    if (auto report = huge_page_report(); !report.empty()) {
+        std::cout << report << '\n';
     }
+}
 
-    return board[row][column];
+void report_unavailable_counters(const PerfCounters &perf) {
+    if (!perf.unavailable().empty()) {
+        std::cerr << "perf counters unavailable: " << perf.unavailable() << '\n';
+    }
 }
 
 template<size_t size>
-std::optional<Move> get_move(const Board<size> &board, Coordinate offset) {
-    auto directions = std::array<std::tuple<int, int>, 4>{std::tuple{0, 1}, {1, 0}, {-1, 0}, {0, -1}};
-
-    for (int row = 0; row < size; ++row) {
-        for (int column = 0; column < size; ++column) {
-            auto [row_offset, column_offset] = offset;
-
-            int offsetted_row = (row + row_offset) % size;
-            int offsetted_column = (column + column_offset) % size;
-
-            auto cell = get_from_board(board, offsetted_row, offsetted_column);
-            assert(cell);
-            if (cell.value() == FieldState::OCCUPIED) {
-                for (const auto &[row_direction, column_direction]: directions) {
-                    auto next_to = get_from_board(board, offsetted_row + row_direction,
-                                                  offsetted_column + column_direction);
-                    if (!next_to || (*next_to != FieldState::OCCUPIED)) { continue; }
-                    auto target_row = offsetted_row + 2 * row_direction;
-                    auto target_column = offsetted_column + 2 * column_direction;
-                    auto over_one = get_from_board(board, target_row, target_column);
-                    if (!over_one || (*over_one != FieldState::EMPTY)) { continue; }
-                    return Move{{offsetted_row, offsetted_column},
-                                {target_row,    target_column}};
+int run_command(const Options &options, size_t seed) {
+    const auto &command = options.command;
+    auto start = start_board<size>;
+    Policy policy = options.policy.value_or(command == "solve" ? Policy::MOBILITY : Policy::SCAN);
+
+    if (command == "simulate" && !options.seeds) {
+        std::ios::sync_with_stdio(false);
+        Renderer renderer(std::cout, options.render_mode, options.frames_per_second);
+        run_simulation<size>(seed, renderer, policy);
+        return 0;
+    }
+    if (command == "bench") {
+        std::optional<PerfCounters> perf;
+        if (options.perf) {
+            perf.emplace();
+            report_unavailable_counters(*perf);
+        }
+        for (auto [name, bench_policy, n_games]: {std::tuple{"scan", Policy::SCAN, size_t{300000}},
+                                                  {"uniform", Policy::UNIFORM, size_t{100000}},
+                                                  {"mobility", Policy::MOBILITY, size_t{20000}}}) {
+            if (options.policy && *options.policy != bench_policy) { continue; }
+            auto result = run_benchmark<size>(bench_policy, options.max_games.value_or(n_games));
+            std::cout << name << ": " << result.n_games << " games in " << result.seconds << " s, "
+                      << result.n_games / result.seconds << " games/s, " << result.n_moves / result.seconds
+                      << " moves/s, best score " << result.best_score << '\n';
+            if (perf && perf->any()) {
+                bool phases = bench_policy == Policy::SCAN;
+                auto profile = profile_benchmark<size>(bench_policy, options.max_games.value_or(n_games), phases);
+                print_perf_counts(std::cout, "playout", profile.playout, profile.n_games, profile.n_moves);
+                if (phases) {
+                    print_perf_counts(std::cout, "rng", profile.rng, profile.n_games, profile.n_moves);
+                    print_perf_counts(std::cout, "move generation", profile.generation, profile.n_games,
+                                      profile.n_moves);
+                    print_perf_counts(std::cout, "move application", profile.application, profile.n_games,
+                                      profile.n_moves);
                 }
             }
         }
+        if (!options.policy) {
+            size_t n_draws = size_t{1} << 27;
+            Xoshiro256StarStar xoshiro(1);
+            Pcg64 pcg(1);
+            LibcRandom libc;
+            XoshiroLanes<> lanes(1);
+            std::cout << "bounded draws/s: xoshiro256** " << benchmark_draws(xoshiro, n_draws) << ", pcg64 "
+                      << benchmark_draws(pcg, n_draws) << ", libc " << benchmark_draws(libc, n_draws) << '\n'
+                      << "bulk fill values/s: xoshiro256** " << benchmark_fill(xoshiro, n_draws) << ", pcg64 "
+                      << benchmark_fill(pcg, n_draws) << ", 4 lanes of xoshiro256** " << benchmark_fill(lanes, n_draws)
+                      << '\n';
+        }
+        return 0;
+    }
+    if (command == "enumerate") {
+        auto n_positions = enumerate_positions(start, options.depth, options.threads, [](size_t depth, size_t count) {
+            std::cout << "depth " << depth << ": " << count << " positions" << std::endl;
+        });
+        std::cout << "Found " << n_positions << " distinct positions.\n";
+        return 0;
+    }
+    if (command == "targets") {
+        auto finishes = reachable_finishes(start);
+        std::cout << "Position class of the starting board is " << position_class<size>(start.pegs)
+                  << ". The last peg can only end on cells marked x:\n";
+        for (size_t row = 0; row < size; ++row) {
+            for (size_t column = 0; column < size; ++column) {
+                std::cout << (!is_usable<size>(row, column) ? ' ' : finishes & cell_bit<size>(row, column) ? 'x' : '.');
+            }
+            std::cout << '\n';
+        }
+        return 0;
+    }
+    if (command == "beam") {
+        BeamSearch search(start, options.width, options.heuristic, options.threads);
+        print_search_result(search.search());
+        return 0;
     }
-    return {};
-}
-
-
-template<size_t size>
-void do_move(Board<size> &board, const Move &move) {
-    auto [from_row, from_column] = move.from;
-    auto [to_row, to_column] = move.to;
-
-    auto &from = board[from_row][from_column];
-    assert(from == FieldState::OCCUPIED);
-    from = FieldState::EMPTY;
-
-    auto &to = board[to_row][to_column];
-    assert(from == FieldState::EMPTY);
-    to = FieldState::OCCUPIED;
-    auto &over = board[std::midpoint(from_row, to_row)][std::midpoint(from_column, to_column)];
-    assert(over == FieldState::OCCUPIED);
-    over = FieldState::EMPTY;
-}
-
-template<size_t size>
-int get_score(const Board<size> &board) {
-    std::vector<int> results;
-    std::transform(board.begin(), board.end(), std::back_inserter(results), [](const auto &v) {
-        return std::count_if(v.begin(), v.end(), [](auto cell) { return cell == FieldState::OCCUPIED; });
-    });
-    auto result = std::accumulate(results.begin(), results.end(), 0);
-    return result;
-}
 
-int run_simulation(size_t seed, bool print_run) {
-    srand(seed);
-    std::vector<Move> move_history;
+    std::optional<Bits> target;
+    if (options.target) {
+        target = parse_target<size>(*options.target);
+        if (!target) {
+            std::cerr << "unable to parse target " << *options.target << '\n';
+            return 1;
+        }
+        if (!can_reach(start, *target)) {
+            std::cerr << "target is unreachable from the starting board, its position class is "
+                      << position_class<size>(*target) << " instead of " << position_class<size>(start.pegs) << '\n';
+            return 1;
+        }
+    }
+    int lower_bound = score_lower_bound(start);
+    int target_score = options.target_score.value_or(lower_bound);
+    if (target_score < lower_bound) {
+        std::cerr << "target score " << target_score << " is unreachable from the starting board, the lowest "
+                  << "reachable score is " << lower_bound << '\n';
+        return 1;
+    }
 
-    int constexpr board_size = 9;
-    auto board = make_board<board_size>();
+    std::optional<GameLogWriter<size>> log;
+    if (options.out) {
+        log.emplace(*options.out, uint8_t(policy));
+    }
 
-    size_t rx = rand();
-    size_t ry = rand();
-    Coordinate randomized_offset{rx, ry};
+    if (command == "solve") {
+        std::optional<SolvedCache<size>> cache;
+        if (options.cache) {
+            cache.emplace(*options.cache, *target);
+            std::cout << "Cache holds " << cache->table_entries() << " compacted and " << cache->logged_entries()
+                      << " logged positions.\n";
+        }
+        Solver<size> solver(Target<size>(*target), policy, cache ? &*cache : nullptr);
+        auto solution = solver.solve(start);
+        std::cout << "Searched " << solver.nodes() << " positions, " << solver.dead_positions() << " proven dead";
+        if (cache) {
+            cache->flush();
+            std::cout << ", " << solver.cache_hits() << " known dead from the cache; logged "
+                      << cache->recorded_entries() << " new proofs";
+        }
+        std::cout << ".\n";
+        if (!solution) {
+            std::cout << "No game ends on the target.\n";
+            return 1;
+        }
+        SearchResult result;
+        result.score = popcount(*target);
+        result.moves = *solution;
+        print_search_result(result);
+        if (log) {
+            log->write(0, result.score, result.moves);
+        }
+        return 0;
+    }
+    if (command == "simulate") {
+        std::ios::sync_with_stdio(false);
+        std::ifstream file;
+        std::istream *input = &std::cin;
+        if (*options.seeds != "-") {
+            file.open(*options.seeds);
+            if (!file) {
+                std::cerr << "unable to open " << *options.seeds << '\n';
+                return 1;
+            }
+            input = &file;
+        }
+        try {
+            simulate_batch<size>(*input, policy, options.threads, [&](const BatchResult &result) {
+                if (log) {
+                    log->write(result.seed, result.score, result.moves);
+                } else {
+                    std::cout << result.seed << ' ' << result.score << ' ' << result.moves.size() << '\n';
+                }
+            });
+        } catch (const std::exception &error) {
+            std::cout.flush();
+            std::cerr << error.what() << '\n';
+            return 1;
+        }
+        return 0;
+    }
 
-    auto possible_move = get_move(board, randomized_offset);
-    if (print_run) {
-        system("clear");
-        std::cout << board;
+    if ((command != "find" || !target) && !options.target_score && lower_bound > 1) {
+        std::cout << "No single-peg finish is reachable from the starting board (position class "
+                  << position_class<size>(start.pegs) << "), stopping at score " << lower_bound << ".\n";
+    }
+    if (command == "count") {
+        std::optional<Target<size>> goal;
+        if (target) {
+            goal.emplace(*target);
+        }
+        auto n_paths = count_paths<size>(start, target ? popcount(*target) : target_score, goal, options.threads,
+                                         [](size_t depth, size_t n_orbits, PathCount n_paths) {
+            std::cout << "depth " << depth << ": " << n_orbits << " positions up to symmetry, "
+                      << to_decimal(n_paths) << " paths" << std::endl;
+        });
+        std::cout << to_decimal(n_paths) << " jump sequences end "
+                  << (target ? "on the target" : "with " + std::to_string(target_score) + " pegs") << ".\n";
+        return 0;
     }
-    int score = board_size * board_size - 13;
-    while (possible_move) {
-        if (print_run) {
-            std::this_thread::sleep_for(std::chrono::milliseconds(500));
-            system("clear");
+    if (command == "winrate") {
+        auto print = [](const char *name, const WinRate &rate, const WinTally *tally) {
+            auto interval = [&](size_t successes, size_t trials) {
+                auto [low, high] = wilson_interval(successes, trials);
+                std::ostringstream text;
+                text << " [" << low << ", " << high << "]";
+                return text.str();
+            };
+            std::cout << name << ": win probability " << rate.win;
+            if (tally) {
+                std::cout << interval(tally->n_wins, tally->n_games) << " from " << rate.n_games << " games\n";
+            } else {
+                std::cout << " over " << rate.n_positions << " positions\n";
+            }
+            for (const auto &first: rate.first_moves) {
+                std::cout << "    first jump " << first.move << ": chosen " << first.chosen << ", wins " << first.won;
+                if (tally) {
+                    auto code = encode_move<size>(first.move);
+                    std::cout << interval(tally->first_wins[code], tally->first_games[code]);
+                }
+                std::cout << '\n';
+            }
+            for (size_t depth = 0; depth < rate.depths.size(); ++depth) {
+                std::cout << "    depth " << depth << ": reached " << rate.depths[depth].reached << ", wins "
+                          << rate.depths[depth].won;
+                if (tally) {
+                    std::cout << interval(tally->reached_wins[depth], tally->reached[depth]);
+                }
+                std::cout << '\n';
+            }
+        };
+        if (options.exact) {
+            if (policy != Policy::SCAN && policy != Policy::UNIFORM) {
+                std::cerr << "exact probabilities need the scan or uniform policy\n";
+                return 1;
+            }
+            print("exact", exact_win_rate(start, policy, target_score, options.threads), nullptr);
         }
+        auto [rate, tally] = sampled_win_rate<size>(policy, target_score, options.max_games.value_or(1000000),
+                                                    options.threads);
+        print("sampled", rate, &tally);
+        return 0;
+    }
+    if (command == "mcts") {
+        Mcts tree(start, 0.2, policy);
+        auto result = tree.search(options.playouts, target_score);
+        print_search_result(result);
+        std::cout << "Search tree has " << tree.tree_size() << " nodes.\n";
+        return 0;
+    }
+    if (command == "nmcs") {
+        SearchResult result;
+        PlayoutPolicy<size> playout_policy(policy);
+        result.score = nested_search(start, int(options.level), result.moves, result.n_playouts, playout_policy,
+                                     target_score);
+        print_search_result(result);
+        return 0;
+    }
 
-        const auto &move = *possible_move;
-        do_move(board, move);
-        move_history.push_back(move);
-        if (print_run) {
-            std::cout << board;
+    FindSettings settings{size, int(policy), rng_version, target_score, target ? *options.target : ""};
+    FindProgress progress;
+    if (options.checkpoint) {
+        if (auto saved = load_checkpoint(*options.checkpoint, settings)) {
+            progress = *saved;
+            std::cout << "resuming from seed " << progress.next_seed << " after " << progress.n_games << " games\n";
         }
-        size_t rx = rand();
-        size_t ry = rand();
-        Coordinate randomized_offset{rx, ry};
-        possible_move = get_move(board, randomized_offset);
-        --score;
+    }
+    if (progress.n_games == 0) {
+        progress.first_seed = progress.next_seed = seed;
     }
 
+    std::optional<Target<size>> goal;
+    if (target) {
+        goal.emplace(*target);
+    }
+    auto play = [&](uint64_t game_seed, std::vector<Move> &moves) {
+        if (goal) {
+            return run_targeted(game_seed, policy, *goal, moves);
+        }
+        return play_game<size>(game_seed, policy, moves) <= target_score;
+    };
+    auto record = [&](uint64_t game_seed, int score, const std::vector<Move> &moves) {
+        if (log) {
+            log->write(game_seed, score, moves);
+        }
+    };
+    auto report = [&](const FindProgress &snapshot) {
+        std::cout << "best score in " << snapshot.n_games << " games is " << snapshot.best_score << " for seed "
+                  << snapshot.best_seed << std::endl;
+        if (options.checkpoint) {
+            save_checkpoint(*options.checkpoint, settings, snapshot);
+        }
+    };
+
+    // counters opened before the workers start count them too
+    std::optional<PerfCounters> perf;
+    auto histogram_before = progress.histogram;
+    size_t n_games_before = progress.n_games;
+    if (options.perf) {
+        perf.emplace(true);
+        report_unavailable_counters(*perf);
+        perf->start();
+    }
 
-    if (print_run) {
-        std::cout << "Using seed " << seed << ".\nEnded with " << score << " matches remaining. Took "
-                  << move_history.size() << " moves:\n";
-        char *sep = "";
-        for (const auto &move: move_history) {
-            std::cout << sep << move;
-            sep = " ; ";
+    install_stop_handlers();
+    auto end = find_games(progress, popcount(start.pegs), play, record, report, options.threads,
+                          options.max_games.value_or(SIZE_MAX), options.time_limit);
+    if (perf && perf->any()) {
+        perf->stop();
+        histogram_before.resize(progress.histogram.size());
+        size_t n_moves = 0;
+        for (size_t score = 0; score < progress.histogram.size(); ++score) {
+            n_moves += (progress.histogram[score] - histogram_before[score]) * (popcount(start.pegs) - score);
         }
-        std::cout << '\n';
+        std::cout << "perf counters of the search:\n";
+        print_perf_counts(std::cout, "find", perf->read(), progress.n_games - n_games_before, n_moves);
+    }
+    if (log) {
+        log->flush();
+    }
+    if (options.checkpoint) {
+        save_checkpoint(*options.checkpoint, settings, progress);
     }
 
-    return score;
+    std::cout << "Played " << progress.n_games << " games, seeds " << progress.first_seed << " to "
+              << progress.next_seed - 1 << ".\n";
+    if (!target) {
+        for (size_t score = 0; score < progress.histogram.size(); ++score) {
+            if (progress.histogram[score]) {
+                std::cout << "score " << score << ": " << progress.histogram[score] << " games\n";
+            }
+        }
+    }
+    std::cout << "best score is " << progress.best_score << " for seed " << progress.best_seed << '\n';
+    switch (end) {
+        case FindEnd::FOUND:
+            std::cout << "* * * winning seed is: " << *progress.winning_seed << '\n';
+            return 0;
+        case FindEnd::BUDGET:
+            std::cout << "no game " << (target ? "ended on the target" : "reached score " + std::to_string(target_score))
+                      << " within the budget\n";
+            return 1;
+        case FindEnd::STOPPED:
+            std::cout << "stopped by signal " << stop_signal.load() << '\n';
+            return 128 + stop_signal.load();
+    }
+    return 0;
 }
 
 int main(int argc, const char *argv[]) {
-
-    bool find = false;
-    bool simulate = false;
+    Options options;
     size_t seed = 0;
-
-    if (argc == 2) {
-        find = std::string("find") == argv[1];
-    }
-    if (argc == 3) {
-        simulate = std::string("simulate") == argv[1];
-    }
-    if (simulate) {
-        std::stringstream ss(argv[2]);
-        if (!(ss >> seed)) {
-            std::cerr << "unable to parse seed\n";
-            return 1;
+    try {
+        options = parse_options(argc, argv);
+        if (options.command == "simulate" && !options.seeds && !options.help) {
+            seed = parse_number<size_t>("seed", options.arguments[0]);
         }
-    }
-
-    if (!simulate && !find) {
-        std::cerr << "usage: " << argv[0] << R"( <command> [seed]
-
-    available commands:
-        find            run until a solution with score 1 is found
-        simulate        simulate a game from given seed
-
-    arguments:
-        seed            provide seed for a given simulation, only
-                        used when command is "simulate".
-                        use seed 0 for random seed.
-)" << '\n';
+    } catch (const std::invalid_argument &error) {
+        std::cerr << error.what() << "\nrun " << argv[0] << " --help for usage\n";
         return 1;
     }
+    if (options.help) {
+        print_usage(argv[0]);
+        return 0;
+    }
+
     if (seed == 0) {
         srand(time(nullptr));
         seed = rand();
     } else {
         srand(seed);
     }
-    if (simulate) {
-        run_simulation(seed, true);
-        return 0;
+    seed_random(seed);
+    if (options.pin) {
+        const auto &placement = enable_thread_pinning();
+        std::cerr << "pinning workers to " << placement.cpus.size() << " CPUs on " << placement.n_nodes
+                  << " NUMA node" << (placement.n_nodes == 1 ? "" : "s") << '\n';
     }
-    if (find) {
-        int score = 0;
-        int n_iterations = 0;
-        int best_score = INT_MAX;
-        size_t best_seed = 0;
-        int granularity = 100000;
-        srand(time(nullptr));
 
-        do {
-            seed = rand();
-            score = run_simulation(seed, false);
-            n_iterations++;
-            if (score < best_score) {
-                best_score = score;
-                best_seed = seed;
-            }
-            if ((n_iterations % granularity) == 0) {
-                std::cout << "best score in " << n_iterations << " runs is " << best_score << " for seed " << best_seed
-                          << '\n';
-                n_iterations = 0;
-                best_score = INT_MAX;
-                best_seed = 0;
-                srand(time(nullptr));
+    try {
+        if (options.command == "replay") {
+            return replay_log(options.arguments[0]);
+        }
+        if (options.command == "regress") {
+            int status = 0;
+            for (const auto &path: options.arguments) {
+                status = std::max(status, regress_corpus(path, options));
             }
-        } while (score != 1);
-        std::cout << "* * * winning seed is: " << seed << '\n';
-        return 0;
+            return status;
+        }
+        if (options.command == "compact") {
+            auto result = compact_solved_cache(options.arguments[0]);
+            std::cout << "Compacted " << result.n_log_records << " logged proofs into a table of "
+                      << result.n_entries << " positions in " << result.capacity << " slots.\n";
+            print_huge_page_report();
+            return 0;
+        }
+        if (options.command == "verify") {
+            return verify_games(options.arguments[0], options.size, options.threads);
+        }
+        int status = with_board_size(options.size, [&](auto size) { return run_command<size>(options, seed); });
+        print_huge_page_report();
+        if (options.trace) {
+            write_trace(*options.trace);
+        }
+        return status;
+    } catch (const std::exception &error) {
+        std::cout.flush();
+        std::cerr << error.what() << '\n';
+        return 1;
     }
-
-    return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,194 @@
+#pragma once
+
+#include <vector>
+#include <memory_resource>
+#include <cmath>
+#include <cstdlib>
+#include <climits>
+
+#include "board.h"
+#include "bitboard.h"
+#include "policy.h"
+#include "simulation.h"
+#include "hugepage.h"
+#include "arena.h"
+
+struct TreeNode {
+    Move move;
+    size_t parent = 0;
+    size_t first_child = 0;
+    size_t n_children = 0;
+    bool expanded = false;
+    double visits = 0;
+    double total_reward = 0;
+};
+
+template<size_t size>
+class Mcts {
+public:
+    Mcts(const BitBoard<size> &root, double exploration, Policy rollout_policy = Policy::SCAN)
+            : root(root), exploration(exploration), initial_score(popcount(root.pegs)), policy(rollout_policy) {
+        nodes.push_back(TreeNode{});
+    }
+
+    SearchResult search(size_t max_playouts, int target_score = 1) {
+        SearchResult result;
+        std::vector<size_t> path;
+        std::vector<Move> history;
+
+        while (result.n_playouts < max_playouts && result.score > target_score) {
+            auto board = root;
+            size_t node = 0;
+            path.clear();
+            path.push_back(node);
+            history.clear();
+
+            while (nodes[node].expanded && nodes[node].n_children > 0) {
+                node = select_child(node);
+                do_move(board, nodes[node].move);
+                history.push_back(nodes[node].move);
+                path.push_back(node);
+            }
+
+            if (!nodes[node].expanded) {
+                expand(node, board);
+                if (nodes[node].n_children > 0) {
+                    node = nodes[node].first_child + random_below(nodes[node].n_children);
+                    do_move(board, nodes[node].move);
+                    history.push_back(nodes[node].move);
+                    path.push_back(node);
+                }
+            }
+
+            int score = play_out(board, history, policy);
+            ++result.n_playouts;
+            if (score < result.score) {
+                result.score = score;
+                result.moves = history;
+            }
+
+            double reward = initial_score > 1 ? double(initial_score - score) / (initial_score - 1) : 1.0;
+            for (auto visited: path) {
+                nodes[visited].visits += 1;
+                nodes[visited].total_reward += reward;
+            }
+        }
+
+        return result;
+    }
+
+    size_t tree_size() const {
+        return nodes.size();
+    }
+
+private:
+    size_t select_child(size_t node) const {
+        const auto &parent = nodes[node];
+        double log_visits = std::log(parent.visits);
+        size_t best = parent.first_child;
+        double best_value = -1;
+        for (size_t child = parent.first_child; child < parent.first_child + parent.n_children; ++child) {
+            const auto &stats = nodes[child];
+            if (stats.visits == 0) {
+                return child;
+            }
+            double value = stats.total_reward / stats.visits + exploration * std::sqrt(log_visits / stats.visits);
+            if (value > best_value) {
+                best_value = value;
+                best = child;
+            }
+        }
+        return best;
+    }
+
+    void expand(size_t node, const BitBoard<size> &board) {
+        get_moves(board, moves);
+        nodes[node].expanded = true;
+        nodes[node].first_child = nodes.size();
+        nodes[node].n_children = moves.size();
+        for (const auto &move: moves) {
+            nodes.push_back(TreeNode{move, node});
+        }
+    }
+
+    BitBoard<size> root;
+    double exploration;
+    int initial_score;
+    PlayoutPolicy<size> policy;
+    HugeVector<TreeNode> nodes;
+    std::vector<Move> moves;
+};
+
+// move lists of one level of nested search, allocated from the thread's arena; they are reserved for
+// the longest game up front, as growing one would allocate past the scope of a deeper level
+using MoveBuffer = std::pmr::vector<Move>;
+
+inline MoveBuffer make_move_buffer(Arena &arena, size_t capacity) {
+    MoveBuffer buffer(&arena);
+    buffer.reserve(capacity);
+    return buffer;
+}
+
+template<size_t size>
+int nested_level(const BitBoard<size> &board, int level, MoveBuffer &sequence, size_t &n_playouts,
+                 PlayoutPolicy<size> &policy, int target_score) {
+    sequence.clear();
+    if (level == 0) {
+        auto position = board;
+        ++n_playouts;
+        return play_out(position, sequence, policy);
+    }
+
+    // everything this level allocates is released in one step when it returns
+    auto &arena = thread_arena();
+    ArenaScope scope(arena);
+    auto position = board;
+    int best_score = INT_MAX;
+    auto best_sequence = make_move_buffer(arena, sequence.capacity());
+    auto played = make_move_buffer(arena, sequence.capacity());
+    auto candidate = make_move_buffer(arena, sequence.capacity());
+    auto moves = make_move_buffer(arena, 4 * size * size);
+
+    get_moves(position, moves);
+    policy.order(position, moves);
+    while (!moves.empty()) {
+        for (const auto &move: moves) {
+            do_move(position, move);
+            int score = nested_level(position, level - 1, candidate, n_playouts, policy, target_score);
+            undo_move(position, move);
+            if (score < best_score) {
+                best_score = score;
+                best_sequence = played;
+                best_sequence.push_back(move);
+                best_sequence.insert(best_sequence.end(), candidate.begin(), candidate.end());
+            }
+            if (best_score <= target_score) {
+                sequence = best_sequence;
+                return best_score;
+            }
+        }
+
+        const auto &move = best_sequence[played.size()];
+        do_move(position, move);
+        played.push_back(move);
+        get_moves(position, moves);
+        policy.order(position, moves);
+    }
+
+    if (played.empty()) {
+        return popcount(position.pegs);
+    }
+    sequence = best_sequence;
+    return best_score;
+}
+
+template<size_t size>
+int nested_search(const BitBoard<size> &board, int level, std::vector<Move> &sequence, size_t &n_playouts,
+                  PlayoutPolicy<size> &policy, int target_score = 1) {
+    auto &arena = thread_arena();
+    ArenaScope scope(arena);
+    auto found = make_move_buffer(arena, popcount(board.pegs));
+    int score = nested_level(board, level, found, n_playouts, policy, target_score);
+    sequence.assign(found.begin(), found.end());
+    return score;
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <string>
+#include <sstream>
+#include <fstream>
+#include <vector>
+#include <algorithm>
+
+#include <sched.h>
+#include <pthread.h>
+
+// "0-3,8,10-11" as in sysfs cpu lists
+inline std::vector<int> parse_cpu_list(const std::string &text) {
+    std::vector<int> cpus;
+    std::stringstream ss(text);
+    std::string range;
+    while (std::getline(ss, range, ',')) {
+        int first;
+        char dash;
+        std::stringstream range_stream(range);
+        if (!(range_stream >> first)) { continue; }
+        int last = first;
+        if (range_stream >> dash && dash == '-') {
+            range_stream >> last;
+        }
+        for (int cpu = first; cpu <= last; ++cpu) {
+            cpus.push_back(cpu);
+        }
+    }
+    return cpus;
+}
+
+// the CPUs this process may run on, grouped by NUMA node; one node holding all of them where sysfs
+// describes no nodes
+inline std::vector<std::vector<int>> read_numa_nodes() {
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) {
+        return {};
+    }
+    std::vector<std::vector<int>> nodes;
+    std::vector<int> seen;
+    for (int node = 0;; ++node) {
+        std::ifstream file("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+        std::string list;
+        if (!file || !std::getline(file, list)) { break; }
+        std::vector<int> cpus;
+        for (auto cpu: parse_cpu_list(list)) {
+            if (cpu < CPU_SETSIZE && CPU_ISSET(cpu, &allowed)) {
+                cpus.push_back(cpu);
+                seen.push_back(cpu);
+            }
+        }
+        if (!cpus.empty()) {
+            nodes.push_back(cpus);
+        }
+    }
+    std::vector<int> rest;
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+        if (CPU_ISSET(cpu, &allowed) && std::find(seen.begin(), seen.end(), cpu) == seen.end()) {
+            rest.push_back(cpu);
+        }
+    }
+    if (!rest.empty()) {
+        nodes.push_back(rest);
+    }
+    return nodes;
+}
+
+// where workers run when pinning is on; set up once before any worker starts
+struct ThreadPlacement {
+    bool enabled = false;
+    size_t n_nodes = 0;
+    // allowed CPUs node by node
+    std::vector<int> cpus;
+};
+
+inline ThreadPlacement &thread_placement() {
+    static ThreadPlacement placement;
+    return placement;
+}
+
+inline const ThreadPlacement &enable_thread_pinning() {
+    auto &placement = thread_placement();
+    auto nodes = read_numa_nodes();
+    placement.n_nodes = nodes.size();
+    for (const auto &cpus: nodes) {
+        placement.cpus.insert(placement.cpus.end(), cpus.begin(), cpus.end());
+    }
+    placement.enabled = !placement.cpus.empty();
+    return placement;
+}
+
+// binds the calling worker, number index of n_workers, to one CPU. workers are spread evenly over the
+// CPUs taken node by node, so each node runs a contiguous range of workers; the shards a worker fills
+// are first touched by it and so live on its node. does nothing unless pinning is enabled
+inline void pin_worker(size_t index, size_t n_workers) {
+    const auto &placement = thread_placement();
+    if (!placement.enabled || n_workers == 0) { return; }
+    int cpu = placement.cpus[index % n_workers * placement.cpus.size() / n_workers];
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+}
@@ -0,0 +1,285 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <sstream>
+#include <vector>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+#include <algorithm>
+#include <climits>
+
+#include <unistd.h>
+
+#include "policy.h"
+#include "evaluation.h"
+#include "render.h"
+#include "trace.h"
+
+struct Options {
+    std::string command;
+    std::vector<std::string> arguments;
+
+    size_t size = 9;
+    size_t threads = std::max(std::thread::hardware_concurrency(), 1u);
+    std::optional<Policy> policy;
+    std::optional<int> target_score;
+    std::optional<double> time_limit;
+    std::optional<size_t> max_games;
+    std::optional<std::string> out;
+    std::optional<std::string> target;
+    std::optional<std::string> seeds;
+    std::optional<std::string> checkpoint;
+    std::optional<std::string> cache;
+    std::optional<std::string> trace;
+    Heuristic heuristic = Heuristic::MOBILITY;
+    size_t playouts = 1000000;
+    size_t level = 2;
+    size_t width = 1000;
+    size_t depth = SIZE_MAX;
+    RenderMode render_mode = isatty(STDOUT_FILENO) ? RenderMode::ANIMATE : RenderMode::BOARDS;
+    double frames_per_second = 2;
+    bool exact = false;
+    bool regenerate = false;
+    bool perf = false;
+    bool pin = false;
+    bool help = false;
+};
+
+constexpr size_t supported_sizes[] = {5, 7, 9};
+
+// commands in the order usage lists them, with the number of positional arguments they take
+struct CommandSpec {
+    std::string_view name;
+    size_t min_arguments;
+    size_t max_arguments;
+};
+
+constexpr CommandSpec command_specs[] = {
+        {"find", 0, 0},
+        {"simulate", 1, 1},
+        {"mcts", 0, 0},
+        {"nmcs", 0, 0},
+        {"beam", 0, 0},
+        {"targets", 0, 0},
+        {"solve", 0, 0},
+        {"enumerate", 0, 0},
+        {"count", 0, 0},
+        {"winrate", 0, 0},
+        {"compact", 1, 1},
+        {"replay", 1, 1},
+        {"verify", 1, 1},
+        {"regress", 1, SIZE_MAX},
+        {"bench", 0, 0},
+};
+
+template<typename Number>
+Number parse_number(std::string_view name, const std::string &text) {
+    std::stringstream ss(text);
+    Number value;
+    char rest;
+    if (text.empty() || text[0] == '-' || !(ss >> value) || ss >> rest) {
+        throw std::invalid_argument("unable to parse " + std::string(name) + " " + text);
+    }
+    return value;
+}
+
+// an option applies to the commands listed in commands, separated by spaces; an empty list allows all
+struct OptionSpec {
+    std::string_view name;
+    std::string_view commands;
+    bool takes_value;
+    void (*apply)(Options &options, const std::string &value);
+};
+
+inline const OptionSpec option_specs[] = {
+        {"--size", "", true, [](Options &options, const std::string &value) {
+            options.size = parse_number<size_t>("board size", value);
+            if (std::find(std::begin(supported_sizes), std::end(supported_sizes), options.size) ==
+                std::end(supported_sizes)) {
+                throw std::invalid_argument("board size must be 5, 7 or 9");
+            }
+        }},
+        {"--threads", "find simulate beam enumerate count winrate verify regress", true, [](Options &options, const std::string &value) {
+            options.threads = parse_number<size_t>("thread count", value);
+            if (options.threads == 0) {
+                throw std::invalid_argument("thread count must be positive");
+            }
+        }},
+        {"--policy", "find simulate mcts nmcs solve bench winrate regress", true, [](Options &options, const std::string &value) {
+            options.policy = parse_policy(value);
+            if (!options.policy) {
+                throw std::invalid_argument("unknown policy " + value);
+            }
+        }},
+        {"--target-score", "find mcts nmcs count winrate", true, [](Options &options, const std::string &value) {
+            options.target_score = int(parse_number<unsigned>("target score", value));
+        }},
+        {"--time-limit", "find", true, [](Options &options, const std::string &value) {
+            options.time_limit = parse_number<double>("time limit", value);
+        }},
+        {"--max-games", "find bench winrate regress", true, [](Options &options, const std::string &value) {
+            options.max_games = parse_number<size_t>("game budget", value);
+        }},
+        {"--out", "find simulate solve", true, [](Options &options, const std::string &value) {
+            options.out = value;
+        }},
+        {"--target", "find solve count", true, [](Options &options, const std::string &value) {
+            options.target = value;
+        }},
+        {"--checkpoint", "find", true, [](Options &options, const std::string &value) {
+            options.checkpoint = value;
+        }},
+        {"--cache", "solve", true, [](Options &options, const std::string &value) {
+            options.cache = value;
+        }},
+        {"--seeds", "simulate", true, [](Options &options, const std::string &value) {
+            options.seeds = value;
+        }},
+        {"--heuristic", "beam", true, [](Options &options, const std::string &value) {
+            auto heuristic = parse_heuristic(value);
+            if (!heuristic) {
+                throw std::invalid_argument("unknown heuristic " + value);
+            }
+            options.heuristic = *heuristic;
+        }},
+        {"--playouts", "mcts", true, [](Options &options, const std::string &value) {
+            options.playouts = parse_number<size_t>("playout budget", value);
+        }},
+        {"--level", "nmcs", true, [](Options &options, const std::string &value) {
+            options.level = parse_number<size_t>("level", value);
+        }},
+        {"--width", "beam", true, [](Options &options, const std::string &value) {
+            options.width = parse_number<size_t>("beam width", value);
+        }},
+        {"--depth", "enumerate", true, [](Options &options, const std::string &value) {
+            options.depth = parse_number<size_t>("depth", value);
+        }},
+        {"--fps", "simulate", true, [](Options &options, const std::string &value) {
+            options.frames_per_second = parse_number<double>("frame rate", value);
+        }},
+        {"--no-animate", "simulate", false, [](Options &options, const std::string &) {
+            options.render_mode = RenderMode::BOARDS;
+        }},
+        {"--summary", "simulate", false, [](Options &options, const std::string &) {
+            options.render_mode = RenderMode::SUMMARY;
+        }},
+        {"--exact", "winrate", false, [](Options &options, const std::string &) {
+            options.exact = true;
+        }},
+        {"--pin", "find simulate beam enumerate count winrate verify regress", false,
+         [](Options &options, const std::string &) {
+            options.pin = true;
+        }},
+        {"--perf", "find bench", false, [](Options &options, const std::string &) {
+            options.perf = true;
+        }},
+        {"--regenerate", "regress", false, [](Options &options, const std::string &) {
+            options.regenerate = true;
+        }},
+        {"--trace", "", true, [](Options &options, const std::string &value) {
+            if (!tracing_enabled) {
+                throw std::invalid_argument("option --trace needs a build configured with -DSIRKY_TRACE=ON");
+            }
+            options.trace = value;
+        }},
+        {"--help", "", false, [](Options &options, const std::string &) {
+            options.help = true;
+        }},
+};
+
+inline bool applies_to(std::string_view commands, std::string_view command) {
+    if (commands.empty()) { return true; }
+    while (!commands.empty()) {
+        auto end = commands.find(' ');
+        if (commands.substr(0, end) == command) { return true; }
+        commands.remove_prefix(end == std::string_view::npos ? commands.size() : end + 1);
+    }
+    return false;
+}
+
+// options may come before or after the command and take their value as "--name value" or "--name=value";
+// throws std::invalid_argument describing the first problem
+inline Options parse_options(int argc, const char *argv[]) {
+    Options options;
+    std::vector<std::pair<const OptionSpec *, std::string>> given;
+
+    for (int index = 1; index < argc; ++index) {
+        std::string argument = argv[index];
+        if (argument == "-h") {
+            argument = "--help";
+        }
+        if (argument.size() < 2 || argument.compare(0, 2, "--") != 0 || argument == "--") {
+            if (options.command.empty()) {
+                options.command = argument;
+            } else {
+                options.arguments.push_back(argument);
+            }
+            continue;
+        }
+
+        auto equals = argument.find('=');
+        auto name = argument.substr(0, equals);
+        auto spec = std::find_if(std::begin(option_specs), std::end(option_specs),
+                                 [&](const OptionSpec &option) { return option.name == name; });
+        if (spec == std::end(option_specs)) {
+            throw std::invalid_argument("unknown option " + name);
+        }
+        std::string value;
+        if (equals != std::string::npos) {
+            if (!spec->takes_value) {
+                throw std::invalid_argument("option " + name + " takes no value");
+            }
+            value = argument.substr(equals + 1);
+        } else if (spec->takes_value) {
+            if (index + 1 >= argc) {
+                throw std::invalid_argument("option " + name + " needs a value");
+            }
+            value = argv[++index];
+        }
+        given.emplace_back(spec, value);
+    }
+
+    for (const auto &[spec, value]: given) {
+        spec->apply(options, value);
+    }
+    if (options.help) {
+        return options;
+    }
+
+    auto command = std::find_if(std::begin(command_specs), std::end(command_specs),
+                                [&](const CommandSpec &spec) { return spec.name == options.command; });
+    if (command == std::end(command_specs)) {
+        throw std::invalid_argument(options.command.empty() ? "no command given" : "unknown command " + options.command);
+    }
+    for (const auto &[spec, value]: given) {
+        if (!applies_to(spec->commands, options.command)) {
+            throw std::invalid_argument("option " + std::string(spec->name) + " does not apply to " + options.command);
+        }
+    }
+
+    size_t max_arguments = command->max_arguments;
+    size_t min_arguments = command->min_arguments;
+    if (options.command == "simulate") {
+        // a seed list replaces the single seed
+        max_arguments = options.seeds ? 0 : 1;
+        min_arguments = options.seeds ? 0 : 1;
+    }
+    if (options.arguments.size() < min_arguments || options.arguments.size() > max_arguments) {
+        if (max_arguments == SIZE_MAX) {
+            throw std::invalid_argument(options.command + " takes at least " + std::to_string(min_arguments) +
+                                        " argument" + (min_arguments == 1 ? "" : "s"));
+        }
+        throw std::invalid_argument(options.command + " takes " +
+                                    (max_arguments == 0 ? "no" : std::to_string(max_arguments)) + " argument" +
+                                    (max_arguments == 1 ? "" : "s"));
+    }
+    if (options.command == "solve" && !options.target) {
+        throw std::invalid_argument("solve needs a --target");
+    }
+    if (options.out && options.command == "simulate" && !options.seeds) {
+        throw std::invalid_argument("option --out applies to simulate only with --seeds");
+    }
+    return options;
+}
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <cstdint>
+#include <cerrno>
+#include <cstring>
+#include <array>
+#include <string>
+#include <string_view>
+#include <optional>
+#include <ostream>
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+struct PerfEventSpec {
+    std::string_view name;
+    uint32_t type;
+    uint64_t config;
+};
+
+// the hardware events worth tuning playouts against, plus the task clock, which the kernel provides
+// even where the PMU is hidden, as in most virtual machines
+constexpr PerfEventSpec perf_events[] = {
+        {"cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+        {"instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+        {"branch misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+        {"L1d misses", PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | PERF_COUNT_HW_CACHE_OP_READ << 8 |
+                                           PERF_COUNT_HW_CACHE_RESULT_MISS << 16},
+        {"task clock ns", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK},
+};
+
+constexpr size_t n_perf_events = std::size(perf_events);
+
+// counts of each event, empty for the events that could not be opened
+using PerfCounts = std::array<std::optional<double>, n_perf_events>;
+
+// user space counts of the calling thread, and of the threads it creates afterwards with inherit.
+// every event has its own file descriptor rather than sharing a group, so an event the PMU lacks does
+// not take the others down and the kernel can multiplex them; counts are scaled by the share of time
+// each was scheduled. counts accumulate over every start and stop until reset
+class PerfCounters {
+public:
+    explicit PerfCounters(bool inherit = false) {
+        for (size_t index = 0; index < n_perf_events; ++index) {
+            perf_event_attr attributes{};
+            attributes.size = sizeof(attributes);
+            attributes.type = perf_events[index].type;
+            attributes.config = perf_events[index].config;
+            attributes.disabled = 1;
+            attributes.inherit = inherit;
+            attributes.exclude_kernel = 1;
+            attributes.exclude_hv = 1;
+            attributes.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+            fds[index] = int(::syscall(SYS_perf_event_open, &attributes, 0, -1, -1, PERF_FLAG_FD_CLOEXEC));
+            if (fds[index] < 0) {
+                failures += (failures.empty() ? "" : ", ") + std::string(perf_events[index].name) + " (" +
+                            std::strerror(errno) + ")";
+            }
+        }
+    }
+
+    PerfCounters(const PerfCounters &) = delete;
+    PerfCounters &operator=(const PerfCounters &) = delete;
+
+    ~PerfCounters() {
+        for (auto fd: fds) {
+            if (fd >= 0) {
+                ::close(fd);
+            }
+        }
+    }
+
+    bool any() const {
+        for (auto fd: fds) {
+            if (fd >= 0) { return true; }
+        }
+        return false;
+    }
+
+    // the events that could not be opened and why, empty when all could
+    const std::string &unavailable() const {
+        return failures;
+    }
+
+    void reset() {
+        control(PERF_EVENT_IOC_RESET);
+    }
+
+    void start() {
+        control(PERF_EVENT_IOC_ENABLE);
+    }
+
+    void stop() {
+        control(PERF_EVENT_IOC_DISABLE);
+    }
+
+    // counts of inherited threads are added as they exit, so read after joining them
+    PerfCounts read() const {
+        PerfCounts counts;
+        for (size_t index = 0; index < n_perf_events; ++index) {
+            uint64_t values[3];
+            if (fds[index] < 0 || ::read(fds[index], values, sizeof(values)) != sizeof(values)) { continue; }
+            auto [value, enabled, running] = values;
+            counts[index] = running ? double(value) * double(enabled) / double(running) : 0.0;
+        }
+        return counts;
+    }
+
+private:
+    void control(unsigned long request) {
+        for (auto fd: fds) {
+            if (fd >= 0) {
+                ::ioctl(fd, request, 0);
+            }
+        }
+    }
+
+    std::array<int, n_perf_events> fds;
+    std::string failures;
+};
+
+// one line per available event: "  <phase> <event>: <per game> per game, <per move> per move"
+inline void print_perf_counts(std::ostream &out, std::string_view phase, const PerfCounts &counts, size_t n_games,
+                              size_t n_moves) {
+    for (size_t index = 0; index < n_perf_events; ++index) {
+        if (!counts[index]) { continue; }
+        out << "  " << phase << ' ' << perf_events[index].name << ": "
+            << (n_games ? *counts[index] / double(n_games) : 0.0) << " per game, "
+            << (n_moves ? *counts[index] / double(n_moves) : 0.0) << " per move\n";
+    }
+}
@@ -0,0 +1,181 @@
+#pragma once
+
+#include <vector>
+#include <optional>
+#include <string_view>
+#include <cmath>
+#include <cstdlib>
+#include <stdexcept>
+#include <algorithm>
+
+#include "bitboard.h"
+#include "evaluation.h"
+#include "rng.h"
+
+enum class Policy {
+    SCAN,
+    UNIFORM,
+    MOBILITY,
+    EDGE,
+    SOFTMAX,
+    EPSILON_GREEDY,
+};
+
+inline std::optional<Policy> parse_policy(std::string_view name) {
+    if (name == "scan") { return Policy::SCAN; }
+    if (name == "uniform") { return Policy::UNIFORM; }
+    if (name == "mobility") { return Policy::MOBILITY; }
+    if (name == "edge") { return Policy::EDGE; }
+    if (name == "softmax") { return Policy::SOFTMAX; }
+    if (name == "epsilon") { return Policy::EPSILON_GREEDY; }
+    return {};
+}
+
+inline std::string_view policy_name(Policy policy) {
+    switch (policy) {
+        case Policy::SCAN:
+            return "scan";
+        case Policy::UNIFORM:
+            return "uniform";
+        case Policy::MOBILITY:
+            return "mobility";
+        case Policy::EDGE:
+            return "edge";
+        case Policy::SOFTMAX:
+            return "softmax";
+        case Policy::EPSILON_GREEDY:
+            return "epsilon";
+    }
+    return "unknown";
+}
+
+template<size_t size>
+class PlayoutPolicy {
+public:
+    explicit PlayoutPolicy(Policy policy = Policy::SCAN, double temperature = 1.0, double epsilon = 0.1)
+            : policy(policy), temperature(temperature), epsilon(epsilon) {
+        moves.reserve(4 * size * size);
+        weights.reserve(4 * size * size);
+    }
+
+    std::optional<Move> choose(const BitBoard<size> &board) {
+        switch (policy) {
+            case Policy::SCAN: {
+                size_t rx = random_below(size);
+                size_t ry = random_below(size);
+                return get_move(board, Coordinate{rx, ry});
+            }
+            case Policy::UNIFORM:
+                get_moves(board, moves);
+                if (moves.empty()) { return {}; }
+                return moves[random_below(moves.size())];
+            case Policy::MOBILITY:
+                return greedy(board, [](const BitBoard<size> &child, const Move &) {
+                    return double(count_moves(child));
+                });
+            case Policy::EDGE:
+                return greedy(board, [](const BitBoard<size> &, const Move &move) {
+                    return double(edge_score(move));
+                });
+            case Policy::SOFTMAX:
+                return softmax(board);
+            case Policy::EPSILON_GREEDY:
+                if (random_unit() < epsilon) {
+                    get_moves(board, moves);
+                    if (moves.empty()) { return {}; }
+                    return moves[random_below(moves.size())];
+                }
+                return greedy(board, [](const BitBoard<size> &child, const Move &) {
+                    return feature_score(child);
+                });
+            default:
+                throw std::runtime_error("unknown policy");
+        }
+    }
+
+    // sorts moves best first, for solvers that want this policy's preference as move ordering
+    template<typename Moves>
+    void order(const BitBoard<size> &board, Moves &ordered) {
+        ordered_scores.clear();
+        for (const auto &move: ordered) {
+            auto child = board;
+            do_move(child, move);
+            ordered_scores.push_back(policy == Policy::EDGE ? double(edge_score(move)) :
+                                     policy == Policy::MOBILITY ? double(count_moves(child)) :
+                                     feature_score(child));
+        }
+        for (size_t index = 1; index < ordered.size(); ++index) {
+            for (size_t other = index; other > 0 && ordered_scores[other - 1] < ordered_scores[other]; --other) {
+                std::swap(ordered_scores[other - 1], ordered_scores[other]);
+                std::swap(ordered[other - 1], ordered[other]);
+            }
+        }
+    }
+
+    static double feature_score(const BitBoard<size> &board) {
+        auto features = get_features(board);
+        return features.mobility - 2.0 * features.isolated - features.corners;
+    }
+
+    // pegs removed from the outside of the board count for more than pegs removed near the centre
+    static int edge_score(const Move &move) {
+        auto [from_row, from_column] = move.from;
+        auto [to_row, to_column] = move.to;
+        return centre_distance<size>(from_row, from_column) +
+               centre_distance<size>((from_row + to_row) / 2, (from_column + to_column) / 2) -
+               centre_distance<size>(to_row, to_column);
+    }
+
+private:
+    template<typename Score>
+    std::optional<Move> greedy(const BitBoard<size> &board, Score score) {
+        get_moves(board, moves);
+        std::optional<Move> best;
+        double best_score = 0;
+        int ties = 0;
+        for (const auto &move: moves) {
+            auto child = board;
+            do_move(child, move);
+            double value = score(child, move);
+            if (!best || value > best_score) {
+                best = move;
+                best_score = value;
+                ties = 1;
+            } else if (value == best_score && random_below(++ties) == 0) {
+                best = move;
+            }
+        }
+        return best;
+    }
+
+    std::optional<Move> softmax(const BitBoard<size> &board) {
+        get_moves(board, moves);
+        if (moves.empty()) { return {}; }
+        weights.clear();
+        double max_score = -INFINITY;
+        for (const auto &move: moves) {
+            auto child = board;
+            do_move(child, move);
+            weights.push_back(feature_score(child));
+            max_score = std::max(max_score, weights.back());
+        }
+        double total = 0;
+        for (auto &weight: weights) {
+            weight = std::exp((weight - max_score) / temperature);
+            total += weight;
+        }
+        double threshold = random_unit() * total;
+        for (size_t index = 0; index < moves.size(); ++index) {
+            threshold -= weights[index];
+            if (threshold < 0) { return moves[index]; }
+        }
+        return moves.back();
+    }
+
+    Policy policy;
+    double temperature;
+    double epsilon;
+    std::vector<Move> moves;
+    std::vector<double> weights;
+    std::vector<double> ordered_scores;
+};
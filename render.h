@@ -0,0 +1,72 @@
+#pragma once
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <chrono>
+
+#include "board.h"
+
+enum class RenderMode {
+    ANIMATE,
+    BOARDS,
+    SUMMARY,
+};
+
+// draws a game in place with ANSI cursor movement, or dumps it as plain text when animation is off
+class Renderer {
+public:
+    Renderer(std::ostream &os, RenderMode mode, double frames_per_second)
+            : os(os), mode(mode),
+              frame_period(frames_per_second > 0 ? std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                      std::chrono::duration<double>(1.0 / frames_per_second)) : std::chrono::steady_clock::duration{}) {}
+
+    template<size_t size>
+    void frame(const Board<size> &board) {
+        if (mode == RenderMode::SUMMARY) { return; }
+
+        buffer.str({});
+        if (mode == RenderMode::ANIMATE && n_frames > 0) {
+            buffer << "\x1b[" << size << 'F';
+        }
+        buffer << board;
+        if (mode == RenderMode::BOARDS) {
+            buffer << '\n';
+        }
+
+        if (mode == RenderMode::ANIMATE && frame_period.count() > 0) {
+            if (n_frames == 0) {
+                next_frame = std::chrono::steady_clock::now();
+            }
+            std::this_thread::sleep_until(next_frame);
+            next_frame += frame_period;
+        }
+        os << buffer.str();
+        if (mode == RenderMode::ANIMATE) {
+            os.flush();
+        }
+        ++n_frames;
+    }
+
+    void summary(size_t seed, int score, const std::vector<Move> &moves) {
+        os << "Using seed " << seed << ".\nEnded with " << score << " matches remaining. Took "
+           << moves.size() << " moves:\n";
+        const char *sep = "";
+        for (const auto &move: moves) {
+            os << sep << move;
+            sep = " ; ";
+        }
+        os << '\n';
+        n_frames = 0;
+    }
+
+private:
+    std::ostream &os;
+    RenderMode mode;
+    std::chrono::steady_clock::duration frame_period;
+    std::chrono::steady_clock::time_point next_frame;
+    std::ostringstream buffer;
+    size_t n_frames = 0;
+};
@@ -0,0 +1,243 @@
+#pragma once
+
+#include <cstdlib>
+#include <cstdint>
+#include <cstddef>
+#include <array>
+#include <span>
+#include <bit>
+#include <algorithm>
+
+// draws shared by the 64 bit generators: unbiased bounded integers by Lemire's multiply and reject
+// method, doubles from the top 53 bits and a sequential bulk fill
+template<typename Generator>
+class RandomDraws {
+public:
+    uint64_t below(uint64_t bound) {
+        auto &generator = static_cast<Generator &>(*this);
+        unsigned __int128 product = (unsigned __int128) generator() * bound;
+        auto low = uint64_t(product);
+        if (low < bound) {
+            uint64_t threshold = -bound % bound;
+            while (low < threshold) {
+                product = (unsigned __int128) generator() * bound;
+                low = uint64_t(product);
+            }
+        }
+        return uint64_t(product >> 64);
+    }
+
+    double unit() {
+        return (static_cast<Generator &>(*this)() >> 11) * 0x1.0p-53;
+    }
+
+    void fill(std::span<uint64_t> values) {
+        for (auto &value: values) {
+            value = static_cast<Generator &>(*this)();
+        }
+    }
+};
+
+// Steele, Lea and Flood's generator; used to expand one seed into the state of the others
+class SplitMix64 : public RandomDraws<SplitMix64> {
+public:
+    explicit SplitMix64(uint64_t seed = 0) : state(seed) {}
+
+    void seed(uint64_t value) {
+        state = value;
+    }
+
+    uint64_t operator()() {
+        uint64_t z = (state += 0x9e3779b97f4a7c15);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+        return z ^ (z >> 31);
+    }
+
+private:
+    uint64_t state;
+};
+
+// Blackman and Vigna's xoshiro256**
+class Xoshiro256StarStar : public RandomDraws<Xoshiro256StarStar> {
+public:
+    static constexpr uint8_t version = 2;
+
+    explicit Xoshiro256StarStar(uint64_t value = 0) {
+        seed(value);
+    }
+
+    void seed(uint64_t value) {
+        SplitMix64 expand(value);
+        for (auto &word: state) {
+            word = expand();
+        }
+    }
+
+    uint64_t operator()() {
+        uint64_t result = std::rotl(state[1] * 5, 7) * 9;
+        uint64_t t = state[1] << 17;
+        state[2] ^= state[0];
+        state[3] ^= state[1];
+        state[1] ^= state[2];
+        state[0] ^= state[3];
+        state[2] ^= t;
+        state[3] = std::rotl(state[3], 45);
+        return result;
+    }
+
+private:
+    std::array<uint64_t, 4> state;
+};
+
+// O'Neill's PCG64: 128 bit LCG with the xor-shift-low, random-rotate output
+class Pcg64 : public RandomDraws<Pcg64> {
+public:
+    static constexpr uint8_t version = 3;
+
+    explicit Pcg64(uint64_t value = 0) {
+        seed(value);
+    }
+
+    void seed(uint64_t value) {
+        SplitMix64 expand(value);
+        increment = ((unsigned __int128) expand() << 64 | expand()) | 1;
+        state = (unsigned __int128) expand() << 64 | expand();
+        (*this)();
+    }
+
+    uint64_t operator()() {
+        state = state * multiplier + increment;
+        return std::rotr(uint64_t(state >> 64) ^ uint64_t(state), int(state >> 122));
+    }
+
+private:
+    static constexpr unsigned __int128 multiplier =
+            (unsigned __int128) 0x2360ed051fc65da4 << 64 | 0x4385df649fccf645;
+    unsigned __int128 state;
+    unsigned __int128 increment;
+};
+
+// glibc's rand() with per-thread state. bounded draws reduce modulo like the original rand() % n, so
+// seeds replay the games of the first versions of the program
+class LibcRandom {
+public:
+    static constexpr uint8_t version = 1;
+
+    LibcRandom() {
+        initstate_r(1, state, sizeof(state), &data);
+    }
+
+    LibcRandom(const LibcRandom &) = delete;
+    LibcRandom &operator=(const LibcRandom &) = delete;
+
+    void seed(uint64_t value) {
+        srandom_r(unsigned(value), &data);
+    }
+
+    uint64_t operator()() {
+        int32_t result;
+        random_r(&data, &result);
+        return uint64_t(result);
+    }
+
+    uint64_t below(uint64_t bound) {
+        return (*this)() % bound;
+    }
+
+    double unit() {
+        return double((*this)()) / (RAND_MAX + 1.0);
+    }
+
+    void fill(std::span<uint64_t> values) {
+        for (auto &value: values) {
+            value = (*this)();
+        }
+    }
+
+private:
+    char state[128] = {};
+    random_data data = {};
+};
+
+// independent xoshiro256** streams stepped side by side with their state stored lane by lane, so a step
+// of all lanes compiles to a handful of vector instructions; four lanes fill an AVX2 register
+template<size_t lanes = 4>
+class XoshiroLanes {
+public:
+    explicit XoshiroLanes(uint64_t value = 0) {
+        seed(value);
+    }
+
+    void seed(uint64_t value) {
+        SplitMix64 expand(value);
+        for (auto *word: {s0, s1, s2, s3}) {
+            for (size_t lane = 0; lane < lanes; ++lane) {
+                word[lane] = expand();
+            }
+        }
+    }
+
+    // fills values lane by lane, one step of every lane per group of lanes values
+    void fill(std::span<uint64_t> values) {
+        size_t n_whole = values.size() / lanes * lanes;
+        for (size_t index = 0; index < n_whole; index += lanes) {
+            step(values.data() + index);
+        }
+        if (n_whole < values.size()) {
+            uint64_t rest[lanes];
+            step(rest);
+            std::copy_n(rest, values.size() - n_whole, values.begin() + n_whole);
+        }
+    }
+
+private:
+    void step(uint64_t *__restrict out) {
+        for (size_t lane = 0; lane < lanes; ++lane) {
+            // multiplications by 5 and 9 as shifts and adds, which vector units have for 64 bit lanes
+            uint64_t times5 = (s1[lane] << 2) + s1[lane];
+            uint64_t rotated = std::rotl(times5, 7);
+            out[lane] = (rotated << 3) + rotated;
+            uint64_t t = s1[lane] << 17;
+            s2[lane] ^= s0[lane];
+            s3[lane] ^= s1[lane];
+            s1[lane] ^= s2[lane];
+            s0[lane] ^= s3[lane];
+            s2[lane] ^= t;
+            s3[lane] = std::rotl(s3[lane], 45);
+        }
+    }
+
+    alignas(64) uint64_t s0[lanes], s1[lanes], s2[lanes], s3[lanes];
+};
+
+// the generator behind every playout, chosen with SIRKY_RNG when configuring the build. changing it
+// changes which game a seed plays, tracked by rng_version in game logs and find checkpoints
+#if defined(SIRKY_RNG_LIBC)
+using Random = LibcRandom;
+#elif defined(SIRKY_RNG_PCG)
+using Random = Pcg64;
+#else
+using Random = Xoshiro256StarStar;
+#endif
+
+inline Random &thread_random() {
+    thread_local Random random;
+    return random;
+}
+
+inline void seed_random(size_t seed) {
+    thread_random().seed(seed);
+}
+
+inline uint64_t random_below(uint64_t bound) {
+    return thread_random().below(bound);
+}
+
+inline double random_unit() {
+    return thread_random().unit();
+}
+
+inline void random_fill(std::span<uint64_t> values) {
+    thread_random().fill(values);
+}
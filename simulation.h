@@ -0,0 +1,78 @@
+#pragma once
+
+#include <iostream>
+#include <vector>
+#include <cstdlib>
+#include <climits>
+
+#include "board.h"
+#include "bitboard.h"
+#include "policy.h"
+#include "evaluation.h"
+#include "render.h"
+
+struct SearchResult {
+    int score = INT_MAX;
+    std::vector<Move> moves;
+    size_t n_playouts = 0;
+};
+
+template<size_t size, typename History>
+int play_out(BitBoard<size> &board, History &move_history, PlayoutPolicy<size> &policy) {
+    while (auto possible_move = policy.choose(board)) {
+        do_move(board, *possible_move);
+        move_history.push_back(*possible_move);
+    }
+    return popcount(board.pegs);
+}
+
+// stops as soon as the target can no longer be reached
+template<size_t size, typename History>
+bool play_out(BitBoard<size> &board, History &move_history, PlayoutPolicy<size> &policy,
+              const Target<size> &target) {
+    while (target.feasible(board)) {
+        auto possible_move = policy.choose(board);
+        if (!possible_move) { break; }
+        do_move(board, *possible_move);
+        move_history.push_back(*possible_move);
+    }
+    return target.reached(board);
+}
+
+template<size_t size>
+int play_game(size_t seed, Policy policy, std::vector<Move> &move_history) {
+    seed_random(seed);
+    move_history.clear();
+    auto board = start_board<size>;
+    PlayoutPolicy<size> playout_policy(policy);
+    return play_out(board, move_history, playout_policy);
+}
+
+template<size_t size>
+bool run_targeted(size_t seed, Policy policy, const Target<size> &target, std::vector<Move> &move_history) {
+    seed_random(seed);
+    move_history.clear();
+    auto board = start_board<size>;
+    PlayoutPolicy<size> playout_policy(policy);
+    return play_out(board, move_history, playout_policy, target);
+}
+
+template<size_t size>
+int run_simulation(size_t seed, Renderer &renderer, Policy policy = Policy::SCAN) {
+    seed_random(seed);
+    std::vector<Move> move_history;
+
+    auto board = start_board<size>;
+    PlayoutPolicy<size> playout_policy(policy);
+
+    renderer.frame(to_board(board));
+    while (auto possible_move = playout_policy.choose(board)) {
+        do_move(board, *possible_move);
+        move_history.push_back(*possible_move);
+        renderer.frame(to_board(board));
+    }
+
+    int score = popcount(board.pegs);
+    renderer.summary(seed, score, move_history);
+    return score;
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <vector>
+#include <optional>
+#include <unordered_set>
+#include <algorithm>
+
+#include "bitboard.h"
+#include "evaluation.h"
+#include "policy.h"
+#include "cache.h"
+
+// depth-first search for a sequence of jumps ending exactly on a target pattern; positions proven
+// not to lead there are remembered so transpositions are only searched once. with a solved-position
+// cache for the same target, positions proven by earlier runs are not searched again, known winning
+// moves are tried first, and this run's proofs are recorded for later ones
+template<size_t size>
+class Solver {
+public:
+    Solver(const Target<size> &target, Policy ordering, SolvedCache<size> *cache = nullptr)
+            : target(target), policy(ordering), cache(cache) {}
+
+    std::optional<std::vector<Move>> solve(const BitBoard<size> &root) {
+        n_nodes = 0;
+        n_cache_hits = 0;
+        if (!can_reach(root, target.pattern)) {
+            return {};
+        }
+        auto board = root;
+        MoveStack<size> stack(board);
+        levels.resize(popcount(root.pegs) + 1);
+        if (search(stack)) {
+            if (cache) {
+                auto position = root;
+                cache->record(position.pegs, true);
+                for (const auto &move: stack.moves()) {
+                    do_move(position, move);
+                    cache->record(position.pegs, true);
+                }
+            }
+            return std::vector<Move>(stack.moves().begin(), stack.moves().end());
+        }
+        return {};
+    }
+
+    size_t nodes() const {
+        return n_nodes;
+    }
+
+    size_t dead_positions() const {
+        return dead.size();
+    }
+
+    // positions the cache proved dead without searching them
+    size_t cache_hits() const {
+        return n_cache_hits;
+    }
+
+private:
+    // walks the tree in place on the stack's board, which is left at the solution when one is found
+    bool search(MoveStack<size> &stack) {
+        const auto &board = stack.board();
+        ++n_nodes;
+        if (target.reached(board)) { return true; }
+        if (!target.feasible(board) || dead.contains(board.pegs)) { return false; }
+        if (cache && cache->lookup(board.pegs) == false) {
+            ++n_cache_hits;
+            return false;
+        }
+
+        auto &moves = levels[stack.depth()];
+        get_moves(board, moves);
+        policy.order(board, moves);
+        if (cache) {
+            std::stable_partition(moves.begin(), moves.end(), [&](const Move &move) {
+                auto child = board;
+                do_move(child, move);
+                return cache->lookup(child.pegs) == true;
+            });
+        }
+        for (const auto &move: moves) {
+            stack.push(move);
+            if (search(stack)) { return true; }
+            stack.pop();
+        }
+
+        dead.insert(board.pegs);
+        if (cache) {
+            cache->record(board.pegs, false);
+        }
+        return false;
+    }
+
+    Target<size> target;
+    PlayoutPolicy<size> policy;
+    std::vector<std::vector<Move>> levels;
+    SolvedCache<size> *cache;
+    std::unordered_set<Bits, BitsHash> dead;
+    size_t n_nodes = 0;
+    size_t n_cache_hits = 0;
+};
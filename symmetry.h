@@ -0,0 +1,75 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include <initializer_list>
+#include <algorithm>
+
+#include "bitboard.h"
+
+// the eight symmetries of the square board: identity, rotations by 90, 180 and 270 degrees, and the
+// mirror images of those four
+constexpr size_t n_symmetries = 8;
+
+template<size_t size>
+constexpr Coordinate apply_symmetry(size_t symmetry, size_t row, size_t column) {
+    if (symmetry >= 4) {
+        column = size - 1 - column;
+    }
+    for (size_t turn = 0; turn < symmetry % 4; ++turn) {
+        auto turned_row = column;
+        column = size - 1 - row;
+        row = turned_row;
+    }
+    return {row, column};
+}
+
+// for every symmetry, the cell index each cell index moves to
+template<size_t size>
+constexpr auto symmetry_maps = [] {
+    std::array<std::array<uint8_t, size * stride<size>>, n_symmetries> maps{};
+    for (size_t symmetry = 0; symmetry < n_symmetries; ++symmetry) {
+        for (size_t row = 0; row < size; ++row) {
+            for (size_t column = 0; column < size; ++column) {
+                auto [image_row, image_column] = apply_symmetry<size>(symmetry, row, column);
+                maps[symmetry][cell_index<size>(row, column)] = uint8_t(cell_index<size>(image_row, image_column));
+            }
+        }
+    }
+    return maps;
+}();
+
+template<size_t size>
+constexpr Bits transform(Bits bits, size_t symmetry) {
+    Bits image = 0;
+    for (; bits; bits &= bits - 1) {
+        image |= Bits{1} << symmetry_maps<size>[symmetry][lowest_bit(bits)];
+    }
+    return image;
+}
+
+// symmetries mapping each of the given patterns onto itself
+template<size_t size>
+std::vector<size_t> symmetries_fixing(std::initializer_list<Bits> patterns) {
+    std::vector<size_t> symmetries;
+    for (size_t symmetry = 0; symmetry < n_symmetries; ++symmetry) {
+        bool fixes = true;
+        for (auto pattern: patterns) {
+            fixes = fixes && transform<size>(pattern, symmetry) == pattern;
+        }
+        if (fixes) {
+            symmetries.push_back(symmetry);
+        }
+    }
+    return symmetries;
+}
+
+// the smallest image of bits under the given symmetries, the same for every position of an orbit
+template<size_t size>
+Bits canonical(Bits bits, const std::vector<size_t> &symmetries) {
+    Bits smallest = bits;
+    for (auto symmetry: symmetries) {
+        smallest = std::min(smallest, transform<size>(bits, symmetry));
+    }
+    return smallest;
+}
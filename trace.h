@@ -0,0 +1,156 @@
+#pragma once
+
+#include <string>
+#include <stdexcept>
+
+// scoped spans recorded into per-thread ring buffers and written as Chrome trace JSON, which Perfetto
+// and chrome://tracing open. configure with SIRKY_TRACE=ON to compile them in; otherwise TraceSpan is
+// empty and every span compiles to nothing
+#if defined(SIRKY_TRACE)
+
+#include <cstdint>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <fstream>
+#include <algorithm>
+
+constexpr bool tracing_enabled = true;
+
+struct TraceEvent {
+    const char *name;
+    uint64_t begin_ns;
+    uint64_t end_ns;
+};
+
+// one thread's spans; the oldest are overwritten once capacity is reached
+class TraceBuffer {
+public:
+    explicit TraceBuffer(size_t thread, size_t capacity = 1 << 16) : thread(thread), events(capacity) {}
+
+    void record(const char *name, uint64_t begin_ns, uint64_t end_ns) {
+        events[n_recorded++ % events.size()] = {name, begin_ns, end_ns};
+    }
+
+    const size_t thread;
+    std::vector<TraceEvent> events;
+    size_t n_recorded = 0;
+    bool in_use = true;
+};
+
+// buffers outlive their threads, so workers that have exited still show up in the trace. a thread
+// takes over the buffer of one that has exited, so the short-lived workers of each search level
+// share a few rows of the trace instead of getting one each
+struct TraceRegistry {
+    std::mutex mutex;
+    std::vector<std::shared_ptr<TraceBuffer>> buffers;
+    std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+};
+
+inline TraceRegistry &trace_registry() {
+    static TraceRegistry registry;
+    return registry;
+}
+
+class TraceBufferLease {
+public:
+    TraceBufferLease() {
+        auto &registry = trace_registry();
+        std::lock_guard lock(registry.mutex);
+        for (const auto &free: registry.buffers) {
+            if (!free->in_use) {
+                free->in_use = true;
+                buffer = free;
+                return;
+            }
+        }
+        buffer = std::make_shared<TraceBuffer>(registry.buffers.size());
+        registry.buffers.push_back(buffer);
+    }
+
+    TraceBufferLease(const TraceBufferLease &) = delete;
+    TraceBufferLease &operator=(const TraceBufferLease &) = delete;
+
+    ~TraceBufferLease() {
+        std::lock_guard lock(trace_registry().mutex);
+        buffer->in_use = false;
+    }
+
+    std::shared_ptr<TraceBuffer> buffer;
+};
+
+inline TraceBuffer &trace_buffer() {
+    thread_local TraceBufferLease lease;
+    return *lease.buffer;
+}
+
+inline uint64_t trace_clock() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() -
+                                                                trace_registry().epoch).count();
+}
+
+// records the time from construction to destruction under name, which must be a string literal
+class TraceSpan {
+public:
+    explicit TraceSpan(const char *name) : name(name), begin_ns(trace_clock()) {}
+
+    TraceSpan(const TraceSpan &) = delete;
+    TraceSpan &operator=(const TraceSpan &) = delete;
+
+    ~TraceSpan() {
+        trace_buffer().record(name, begin_ns, trace_clock());
+    }
+
+private:
+    const char *name;
+    uint64_t begin_ns;
+};
+
+// microseconds with nanosecond decimals, the unit of timestamps in the trace format
+inline std::string trace_microseconds(uint64_t ns) {
+    return std::to_string(ns / 1000) + '.' + std::to_string(ns % 1000 + 1000).substr(1);
+}
+
+// writes every recorded span as a complete event; call once the traced threads have finished
+inline void write_trace(const std::string &path) {
+    std::ofstream file(path, std::ios::trunc);
+    if (!file) {
+        throw std::runtime_error("unable to open " + path);
+    }
+    auto &registry = trace_registry();
+    std::lock_guard lock(registry.mutex);
+    file << "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [\n";
+    const char *sep = "";
+    for (const auto &buffer: registry.buffers) {
+        file << sep << R"({"name": "thread_name", "ph": "M", "pid": 1, "tid": )" << buffer->thread
+             << R"(, "args": {"name": "thread )" << buffer->thread << "\"}}";
+        sep = ",\n";
+        size_t n_kept = std::min(buffer->n_recorded, buffer->events.size());
+        for (size_t index = buffer->n_recorded - n_kept; index < buffer->n_recorded; ++index) {
+            const auto &event = buffer->events[index % buffer->events.size()];
+            file << sep << R"({"name": ")" << event.name << R"(", "ph": "X", "pid": 1, "tid": )" << buffer->thread
+                 << R"(, "ts": )" << trace_microseconds(event.begin_ns) << R"(, "dur": )"
+                 << trace_microseconds(event.end_ns - event.begin_ns) << '}';
+        }
+    }
+    file << "\n]}\n";
+    if (!file.flush()) {
+        throw std::runtime_error("unable to write " + path);
+    }
+}
+
+#else
+
+constexpr bool tracing_enabled = false;
+
+class TraceSpan {
+public:
+    explicit TraceSpan(const char *) {}
+};
+
+inline void write_trace(const std::string &) {
+    throw std::runtime_error("tracing is not compiled in, configure with -DSIRKY_TRACE=ON");
+}
+
+#endif
@@ -0,0 +1,150 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <charconv>
+#include <optional>
+#include <sstream>
+#include <istream>
+#include <utility>
+
+#include "bitboard.h"
+#include "game_log.h"
+#include "batch.h"
+
+struct Verdict {
+    size_t game;
+    size_t n_moves;
+    int pegs;
+    std::string error;
+};
+
+// parses moves in the "(r, c) ~> (r, c) ; ..." format printed by simulate; returns the index of the
+// first move that does not parse
+inline std::optional<size_t> parse_moves(std::string_view text, std::vector<Move> &moves) {
+    moves.clear();
+    auto skip_spaces = [&] {
+        while (!text.empty() && (text.front() == ' ' || text.front() == '\t' || text.front() == '\r')) {
+            text.remove_prefix(1);
+        }
+    };
+    auto expect = [&](std::string_view token) {
+        skip_spaces();
+        if (!text.starts_with(token)) { return false; }
+        text.remove_prefix(token.size());
+        return true;
+    };
+    auto number = [&](size_t &value) {
+        skip_spaces();
+        auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+        if (error != std::errc{}) { return false; }
+        text.remove_prefix(end - text.data());
+        return true;
+    };
+    auto coordinate = [&](Coordinate &cell) {
+        size_t row, column;
+        if (!expect("(") || !number(row) || !expect(",") || !number(column) || !expect(")")) { return false; }
+        cell = {row, column};
+        return true;
+    };
+
+    skip_spaces();
+    while (!text.empty()) {
+        Move move;
+        if (!coordinate(move.from) || !expect("~>") || !coordinate(move.to)) {
+            return moves.size();
+        }
+        moves.push_back(move);
+        skip_spaces();
+        if (!text.empty() && !expect(";")) {
+            return moves.size();
+        }
+        skip_spaces();
+    }
+    return {};
+}
+
+template<size_t size>
+Verdict verify_moves(size_t game, const std::vector<Move> &moves) {
+    auto board = start_board<size>;
+    Verdict verdict{game, 0, popcount(board.pegs), {}};
+    for (const auto &move: moves) {
+        if (!is_legal(board, move)) {
+            std::stringstream ss;
+            ss << "illegal jump " << verdict.n_moves << ' ' << move;
+            verdict.error = ss.str();
+            break;
+        }
+        do_move(board, move);
+        ++verdict.n_moves;
+    }
+    verdict.pegs = popcount(board.pegs);
+    return verdict;
+}
+
+template<size_t size>
+Verdict verify_text(size_t game, const std::string &line) {
+    std::vector<Move> moves;
+    auto unparsed = parse_moves(line, moves);
+    auto verdict = verify_moves<size>(game, moves);
+    if (unparsed && verdict.error.empty()) {
+        verdict.error = "unable to parse move " + std::to_string(*unparsed);
+    }
+    return verdict;
+}
+
+template<size_t size>
+Verdict verify_record(size_t game, const GameRecord &record) {
+    auto board = start_board<size>;
+    Verdict verdict{game, 0, popcount(board.pegs), {}};
+    for (auto code: record.moves) {
+        auto move = decode_move(board, code);
+        if (!move) {
+            verdict.error = "illegal jump " + std::to_string(verdict.n_moves);
+            break;
+        }
+        do_move(board, *move);
+        ++verdict.n_moves;
+    }
+    verdict.pegs = popcount(board.pegs);
+    if (verdict.error.empty() && verdict.pegs != record.score) {
+        verdict.error = "ends with " + std::to_string(verdict.pegs) + " pegs, not " + std::to_string(record.score);
+    }
+    return verdict;
+}
+
+// one game per non-empty line
+template<size_t size, typename Emit>
+size_t verify_text_stream(std::istream &input, size_t n_threads, Emit emit) {
+    size_t n_games = 0;
+    auto read = [&](std::vector<std::pair<size_t, std::string>> &games, size_t chunk_size) {
+        std::string line;
+        while (games.size() < chunk_size && std::getline(input, line)) {
+            if (line.find_first_not_of(" \t\r") == std::string::npos) { continue; }
+            games.emplace_back(n_games++, std::move(line));
+        }
+        return bool(input);
+    };
+    auto verify = [](const std::pair<size_t, std::string> &game) {
+        return verify_text<size>(game.first, game.second);
+    };
+    return process_in_order<std::pair<size_t, std::string>, Verdict>(read, verify, emit, n_threads);
+}
+
+template<size_t size, typename Emit>
+size_t verify_log(GameLogReader &reader, size_t n_threads, Emit emit) {
+    size_t n_games = 0;
+    auto read = [&](std::vector<std::pair<size_t, GameRecord>> &games, size_t chunk_size) {
+        GameRecord record{};
+        while (games.size() < chunk_size) {
+            if (!reader.next(record)) { return false; }
+            games.emplace_back(n_games++, record);
+        }
+        return true;
+    };
+    auto verify = [](const std::pair<size_t, GameRecord> &game) {
+        return verify_record<size>(game.first, game.second);
+    };
+    return process_in_order<std::pair<size_t, GameRecord>, Verdict>(read, verify, emit, n_threads);
+}
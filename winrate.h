@@ -0,0 +1,220 @@
+#pragma once
+
+#include <vector>
+#include <array>
+#include <cmath>
+#include <utility>
+#include <algorithm>
+
+#include "bitboard.h"
+#include "policy.h"
+#include "simulation.h"
+#include "enumerate.h"
+#include "game_log.h"
+
+// probability of every jump the policy picks next. only scan and uniform choose by the position alone:
+// scan takes get_move at a uniformly random offset, so a jump is as likely as the number of offsets
+// whose scan reaches it first
+template<size_t size>
+bool move_distribution(const BitBoard<size> &board, Policy policy, std::vector<std::pair<Move, double>> &moves) {
+    moves.clear();
+    if (policy == Policy::UNIFORM) {
+        std::vector<Move> legal;
+        get_moves(board, legal);
+        for (const auto &move: legal) {
+            moves.emplace_back(move, 1.0 / double(legal.size()));
+        }
+        return true;
+    }
+    if (policy != Policy::SCAN) {
+        return false;
+    }
+    for (size_t row = 0; row < size; ++row) {
+        for (size_t column = 0; column < size; ++column) {
+            auto move = get_move(board, Coordinate{row, column});
+            if (!move) { return true; }
+            auto same = std::find_if(moves.begin(), moves.end(), [&](const auto &entry) {
+                return entry.first.from == move->from && entry.first.to == move->to;
+            });
+            if (same == moves.end()) {
+                moves.emplace_back(*move, 0.0);
+                same = moves.end() - 1;
+            }
+            same->second += 1.0 / double(size * size);
+        }
+    }
+    return true;
+}
+
+struct DepthRate {
+    double reached = 0;
+    double won = 0;
+};
+
+struct FirstMoveRate {
+    Move move;
+    double chosen = 0;
+    double won = 0;
+};
+
+// win is the probability of ending with at most the target score; depths[d] holds the probability of
+// making at least d jumps and of winning among those games, first_moves the same split by first jump
+struct WinRate {
+    double win = 0;
+    size_t n_games = 0;
+    size_t n_positions = 0;
+    std::vector<DepthRate> depths;
+    std::vector<FirstMoveRate> first_moves;
+};
+
+// exact probabilities by dynamic programming over every position a playout can reach: reach probabilities
+// flow forward level by level, win probabilities flow back from the final positions
+template<size_t size>
+WinRate exact_win_rate(const BitBoard<size> &root, Policy policy, int target_score, size_t n_threads) {
+    struct Entry {
+        Bits pegs;
+        double reach;
+        double win;
+    };
+
+    std::vector<ShardedLevel<Entry>> levels;
+    auto level = make_level(Entry{root.pegs, 1.0, 0.0}, n_threads);
+    while (level_size(level) > 0) {
+        levels.push_back(level);
+        advance_level(level, [policy](const Entry &parent, auto add) {
+            std::vector<std::pair<Move, double>> moves;
+            move_distribution(BitBoard<size>{parent.pegs}, policy, moves);
+            for (const auto &[move, probability]: moves) {
+                BitBoard<size> child{parent.pegs};
+                do_move(child, move);
+                add({child.pegs, parent.reach * probability, 0.0});
+            }
+        }, [](Entry &kept, const Entry &duplicate) {
+            kept.reach += duplicate.reach;
+        });
+    }
+
+    WinRate result;
+    result.depths.resize(levels.size());
+    for (size_t depth = levels.size(); depth-- > 0;) {
+        auto &current = levels[depth];
+        run_on_threads(current.size(), [&](size_t shard) {
+            std::vector<std::pair<Move, double>> moves;
+            for (auto &entry: current[shard]) {
+                move_distribution(BitBoard<size>{entry.pegs}, policy, moves);
+                if (moves.empty()) {
+                    entry.win = popcount(entry.pegs) <= target_score ? 1.0 : 0.0;
+                    continue;
+                }
+                entry.win = 0;
+                for (const auto &[move, probability]: moves) {
+                    BitBoard<size> child{entry.pegs};
+                    do_move(child, move);
+                    entry.win += probability * find_entry(levels[depth + 1], child.pegs)->win;
+                }
+            }
+        });
+        for (const auto &entries: current) {
+            for (const auto &entry: entries) {
+                result.depths[depth].reached += entry.reach;
+                result.depths[depth].won += entry.reach * entry.win;
+            }
+        }
+        result.n_positions += level_size(current);
+    }
+    for (auto &rate: result.depths) {
+        rate.won = rate.reached > 0 ? rate.won / rate.reached : 0;
+    }
+
+    std::vector<std::pair<Move, double>> moves;
+    move_distribution(root, policy, moves);
+    for (const auto &[move, probability]: moves) {
+        BitBoard<size> child = root;
+        do_move(child, move);
+        result.first_moves.push_back({move, probability, find_entry(levels[1], child.pegs)->win});
+    }
+    result.win = find_entry(levels[0], root.pegs)->win;
+    return result;
+}
+
+// tallies of the sampled games; depth and first move counts are indexed like WinRate
+struct WinTally {
+    size_t n_games = 0;
+    size_t n_wins = 0;
+    std::vector<size_t> reached;
+    std::vector<size_t> reached_wins;
+    std::array<size_t, 256> first_games{};
+    std::array<size_t, 256> first_wins{};
+};
+
+// Monte Carlo estimate from the games of seeds 1..n_games, played on n_threads workers; works for every
+// policy. the tallies are returned alongside so confidence intervals can be computed from counts
+template<size_t size>
+std::pair<WinRate, WinTally> sampled_win_rate(Policy policy, int target_score, size_t n_games, size_t n_threads) {
+    n_threads = std::max<size_t>(n_threads, 1);
+    int start_pegs = popcount(start_board<size>.pegs);
+    std::vector<WinTally> tallies(n_threads);
+    run_on_threads(n_threads, [&](size_t index) {
+        auto &tally = tallies[index];
+        tally.reached.resize(start_pegs);
+        tally.reached_wins.resize(start_pegs);
+        std::vector<Move> moves;
+        for (size_t seed = 1 + index; seed <= n_games; seed += n_threads) {
+            int score = play_game<size>(seed, policy, moves);
+            bool won = score <= target_score;
+            ++tally.n_games;
+            tally.n_wins += won;
+            for (size_t depth = 0; depth <= moves.size(); ++depth) {
+                ++tally.reached[depth];
+                tally.reached_wins[depth] += won;
+            }
+            if (!moves.empty()) {
+                auto code = encode_move<size>(moves.front());
+                ++tally.first_games[code];
+                tally.first_wins[code] += won;
+            }
+        }
+    });
+
+    WinTally total = tallies.front();
+    for (size_t index = 1; index < n_threads; ++index) {
+        const auto &tally = tallies[index];
+        total.n_games += tally.n_games;
+        total.n_wins += tally.n_wins;
+        for (size_t depth = 0; depth < total.reached.size(); ++depth) {
+            total.reached[depth] += tally.reached[depth];
+            total.reached_wins[depth] += tally.reached_wins[depth];
+        }
+        for (size_t code = 0; code < 256; ++code) {
+            total.first_games[code] += tally.first_games[code];
+            total.first_wins[code] += tally.first_wins[code];
+        }
+    }
+
+    WinRate result;
+    result.n_games = total.n_games;
+    result.win = total.n_games ? double(total.n_wins) / double(total.n_games) : 0;
+    for (size_t depth = 0; depth < total.reached.size() && total.reached[depth] > 0; ++depth) {
+        result.depths.push_back({double(total.reached[depth]) / double(total.n_games),
+                                 double(total.reached_wins[depth]) / double(total.reached[depth])});
+    }
+    std::vector<Move> legal;
+    get_moves(start_board<size>, legal);
+    for (const auto &move: legal) {
+        auto code = encode_move<size>(move);
+        if (total.first_games[code] == 0) { continue; }
+        result.first_moves.push_back({move, double(total.first_games[code]) / double(total.n_games),
+                                      double(total.first_wins[code]) / double(total.first_games[code])});
+    }
+    return {result, total};
+}
+
+// 95% Wilson score interval of a proportion of successes out of trials
+inline std::pair<double, double> wilson_interval(size_t successes, size_t trials, double z = 1.959964) {
+    if (trials == 0) { return {0, 1}; }
+    double n = double(trials);
+    double p = double(successes) / n;
+    double centre = (p + z * z / (2 * n)) / (1 + z * z / n);
+    double half_width = z * std::sqrt(p * (1 - p) / n + z * z / (4 * n * n)) / (1 + z * z / n);
+    return {std::max(0.0, centre - half_width), std::min(1.0, centre + half_width)};
+}